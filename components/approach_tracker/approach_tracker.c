@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "approach_tracker.h"
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "dlog.h"
+
+#define ALPHA           (CONFIG_APPROACH_TRACKER_ALPHA_PCT / 100.0f)
+#define BETA            (CONFIG_APPROACH_TRACKER_BETA_PCT / 100.0f)
+#define MIN_SPEED       ((float)CONFIG_APPROACH_TRACKER_MIN_SPEED_CM_S)
+#define GATE_CM         ((float)CONFIG_APPROACH_TRACKER_GATE_CM)
+// Thresholds shared with the occupancy detector, so alert and presence agree on "near"
+#define ENTER_CM        ((float)CONFIG_OCCUPANCY_ENTER_CM)
+#define EXIT_CM         ((float)CONFIG_OCCUPANCY_EXIT_CM)
+// Readings before the velocity is trusted, and the gap after which the track restarts
+#define MIN_SAMPLES     3
+#define MAX_GAP_US      2000000
+
+// Filter state: only touched by the task calling approach_tracker_update()
+static float s_x;
+static float s_v;
+static int64_t s_last_us;
+static uint8_t s_count;
+static uint8_t s_outliers;
+static int64_t s_alert_us;
+static bool s_lead_pending;
+static approach_state_t s_work;
+
+// Copy for readers (HTTP handlers)
+static approach_state_t s_state;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void restart(float z, int64_t t_us)
+{
+    s_x = z;
+    s_v = 0.0f;
+    s_last_us = t_us;
+    s_count = 1;
+    s_outliers = 0;
+}
+
+static void publish(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_state = s_work;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+bool approach_tracker_update(const sample_ring_item_t *item)
+{
+    int64_t t = item->t_us;
+    float z = item->distance;
+    s_work.seq = item->seq;
+
+    if (!item->valid) {
+        // No echo: the target is out of range or gone, nothing to extrapolate from
+        s_count = 0;
+    } else if (s_count == 0 || t - s_last_us > MAX_GAP_US || t <= s_last_us) {
+        restart(z, t);
+    } else {
+        float dt = (float)(t - s_last_us) / 1e6f;
+        float predicted = s_x + s_v * dt;
+        float residual = z - predicted;
+        if (fabsf(residual) > GATE_CM && ++s_outliers < 2) {
+            // Single spurious echo: keep the track, skip the reading
+            return s_work.alert;
+        }
+        if (fabsf(residual) > GATE_CM) {
+            restart(z, t);
+        } else {
+            s_outliers = 0;
+            s_x = predicted + ALPHA * residual;
+            s_v += BETA * residual / dt;
+            s_last_us = t;
+            if (s_count < UINT8_MAX) s_count++;
+        }
+    }
+
+    s_work.tracking = s_count >= MIN_SAMPLES;
+    s_work.distance_cm = s_count && s_x > 0.0f ? s_x : 0.0f;   // Overshoot can extrapolate below 0
+    s_work.velocity_cm_s = s_work.tracking ? s_v : 0.0f;
+    s_work.ttc_ms = 0;
+    bool closing = s_work.tracking && s_v <= -MIN_SPEED && s_x > ENTER_CM;
+    if (closing) {
+        s_work.ttc_ms = (uint32_t)((s_x - ENTER_CM) / -s_v * 1000.0f);
+    }
+
+    bool predicted = s_work.tracking &&
+                     (s_x <= ENTER_CM || (closing && s_work.ttc_ms <= CONFIG_APPROACH_TRACKER_HORIZON_MS));
+    if (!s_work.alert && predicted) {
+        s_work.alert = true;
+        s_work.alerts++;
+        s_alert_us = t;
+        s_lead_pending = true;
+        DLOGI(DLOG_MOD_LED, "approach: alert at %.1f cm, %.1f cm/s, crossing in %lu ms",
+              DLOG_F(s_x), DLOG_F(s_v), DLOG_U(s_work.ttc_ms));
+    } else if (s_work.alert && (!s_work.tracking || s_x > EXIT_CM || s_v >= MIN_SPEED)) {
+        // Hysteresis: hovering at the threshold keeps the alert, receding or leaving clears it
+        s_work.alert = false;
+        s_lead_pending = false;
+    }
+    if (s_lead_pending && item->valid && z < ENTER_CM) {
+        s_work.last_lead_ms = (uint32_t)((t - s_alert_us) / 1000);
+        s_lead_pending = false;
+    }
+
+    publish();
+    return s_work.alert;
+}
+
+void approach_tracker_get(approach_state_t *out)
+{
+    portENTER_CRITICAL(&s_lock);
+    *out = s_state;
+    portEXIT_CRITICAL(&s_lock);
+}
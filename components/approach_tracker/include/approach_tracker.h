@@ -0,0 +1,53 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sample_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Closing-speed tracker.
+ *
+ * An alpha-beta filter over consecutive valid readings estimates distance and
+ * velocity; from them it predicts when the target reaches CONFIG_OCCUPANCY_ENTER_CM.
+ * The predictive alert is raised when that crossing is less than
+ * CONFIG_APPROACH_TRACKER_HORIZON_MS away (or already happened) and cleared once the
+ * target recedes, moves past CONFIG_OCCUPANCY_EXIT_CM or is lost, so the alert leads
+ * the occupancy detector instead of trailing it by a sample period and the dwell.
+ */
+
+typedef struct {
+    uint32_t seq;           // Sample the estimate is based on
+    float distance_cm;      // Filtered distance
+    float velocity_cm_s;    // Rate of change, negative while approaching
+    uint32_t ttc_ms;        // Predicted time to the enter threshold; 0 when not closing in or already inside
+    bool tracking;          // Enough consecutive valid readings for an estimate
+    bool alert;             // Predictive alert active
+    uint32_t alerts;        // Alerts raised since boot
+    uint32_t last_lead_ms;  // How long before the first reading inside the threshold the last alert fired
+} approach_state_t;
+
+/**
+ * @brief Run the tracker on one reading (a single task only, led_task)
+ *
+ * @param item Reading from the sample ring, in sequence order
+ * @return true while the predictive alert is active
+ */
+bool approach_tracker_update(const sample_ring_item_t *item);
+
+/**
+ * @brief Copy the current estimate
+ */
+void approach_tracker_get(approach_state_t *out);
+
+#ifdef __cplusplus
+}
+#endif
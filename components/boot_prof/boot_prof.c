@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "boot_prof.h"
+#include <stdatomic.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "boot";
+
+// 32-bit µs (wraps after ~71 min): a plain atomic word on the C3, no lock needed
+static atomic_uint_least32_t s_marks[BOOT_PHASE_MAX];
+
+static const char *const s_names[BOOT_PHASE_MAX] = {
+    [BOOT_PHASE_APP_MAIN]      = "app_main",
+    [BOOT_PHASE_OLED_READY]    = "oled_ready",
+    [BOOT_PHASE_SENSOR_READY]  = "sensor_ready",
+    [BOOT_PHASE_TASKS_STARTED] = "tasks_started",
+    [BOOT_PHASE_FIRST_SAMPLE]  = "first_sample",
+    [BOOT_PHASE_FIRST_FRAME]   = "first_frame",
+    [BOOT_PHASE_WIFI_STARTED]  = "wifi_started",
+    [BOOT_PHASE_SD_READY]      = "sd_ready",
+    [BOOT_PHASE_GOT_IP]        = "got_ip",
+    [BOOT_PHASE_HTTP_STARTED]  = "http_started",
+    [BOOT_PHASE_FIRST_HTTP]    = "first_http",
+};
+
+void boot_prof_mark(boot_phase_t phase)
+{
+    if ((unsigned)phase >= BOOT_PHASE_MAX ||
+        atomic_load_explicit(&s_marks[phase], memory_order_relaxed) != 0) {
+        return;
+    }
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    if (now == 0) {
+        now = 1;    // 0 means "not reached"
+    }
+    uint_least32_t expected = 0;
+    if (atomic_compare_exchange_strong(&s_marks[phase], &expected, now)) {
+        // Once per phase, so a direct log line is affordable even on the hot paths
+        ESP_LOGI(TAG, "%-14s %7" PRIu32 ".%03" PRIu32 " ms", s_names[phase], now / 1000, now % 1000);
+    }
+}
+
+uint32_t boot_prof_get_us(boot_phase_t phase)
+{
+    if ((unsigned)phase >= BOOT_PHASE_MAX) {
+        return 0;
+    }
+    return atomic_load_explicit(&s_marks[phase], memory_order_relaxed);
+}
+
+const char *boot_prof_name(boot_phase_t phase)
+{
+    if ((unsigned)phase >= BOOT_PHASE_MAX) {
+        return "?";
+    }
+    return s_names[phase];
+}
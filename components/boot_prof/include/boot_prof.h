@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Boot-phase timestamps.
+ *
+ * Each phase records esp_timer time (µs since the app started) the first time it
+ * is marked; later marks are ignored, so the hot paths (first sample, first HTTP
+ * response) can call boot_prof_mark() unconditionally. Phases of subsystems that
+ * start in parallel are independent: there is no ordering between, say,
+ * BOOT_PHASE_SD_READY and BOOT_PHASE_GOT_IP.
+ */
+
+typedef enum {
+    BOOT_PHASE_APP_MAIN,        // app_main entered
+    BOOT_PHASE_OLED_READY,      // Panel initialised
+    BOOT_PHASE_SENSOR_READY,    // Ultrasonic GPIO configured
+    BOOT_PHASE_TASKS_STARTED,   // Sampling/display tasks created
+    BOOT_PHASE_FIRST_SAMPLE,    // sensor_task finished its first measurement
+    BOOT_PHASE_FIRST_FRAME,     // display_task committed the first reading
+    BOOT_PHASE_WIFI_STARTED,    // esp_wifi_start() returned
+    BOOT_PHASE_SD_READY,        // FAT mounted (never marked if the card is missing)
+    BOOT_PHASE_GOT_IP,          // IP_EVENT_STA_GOT_IP
+    BOOT_PHASE_HTTP_STARTED,    // httpd listening
+    BOOT_PHASE_FIRST_HTTP,      // First response sent
+    BOOT_PHASE_MAX
+} boot_phase_t;
+
+/**
+ * @brief Record the current time for a phase (first call only)
+ *
+ * @param phase Phase reached
+ */
+void boot_prof_mark(boot_phase_t phase);
+
+/**
+ * @brief Time a phase was reached
+ *
+ * @param phase Phase
+ * @return uint32_t µs since the app started, 0 if not reached yet
+ */
+uint32_t boot_prof_get_us(boot_phase_t phase);
+
+/**
+ * @brief Phase name as used in logs and the /boot endpoint
+ */
+const char *boot_prof_name(boot_phase_t phase);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,53 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "display_ui.h"
+#include <stdio.h>
+
+#define DISPLAY_UI_RANGE_CM 400.0f
+
+void display_ui_init(display_ui_t *ui)
+{
+    oled_label_init(&ui->title, 64, 3, OLED_FONT_SMALL, OLED_ALIGN_CENTER);
+    oled_sparkline_init(&ui->trend, 0, 13, 128, 16, 0.0f, DISPLAY_UI_RANGE_CM);
+    oled_numeric_init(&ui->distance, 64, 40, OLED_FONT_SMALL, OLED_ALIGN_CENTER,
+                      "Distance: %.1f cm", "Distance: ERROR");
+    oled_label_init(&ui->status, 64, 50, OLED_FONT_SMALL, OLED_ALIGN_CENTER);
+    oled_bar_init(&ui->bar, 4, 58, 120, 6, 0.0f, DISPLAY_UI_RANGE_CM);
+    ui->stats[0] = '\0';
+}
+
+void display_ui_draw_static(oled_driver_t *driver, display_ui_t *ui)
+{
+    oled_clear(driver);
+    oled_label_set(driver, &ui->title, "Distance Logger");
+    oled_draw_hline(driver, 0, 30, 128, 1);
+}
+
+void display_ui_push_sample(oled_driver_t *driver, display_ui_t *ui, float distance, bool valid)
+{
+    oled_sparkline_push(driver, &ui->trend, distance, valid);
+}
+
+void display_ui_show(oled_driver_t *driver, display_ui_t *ui, float distance, bool valid)
+{
+    oled_numeric_set(driver, &ui->distance, distance, valid);
+    const char *status = "Status: OUT OF RANGE";
+    if (valid) {
+        status = ui->stats[0] ? ui->stats : "Status: OK";
+    }
+    oled_label_set(driver, &ui->status, status);
+    oled_bar_set(driver, &ui->bar, valid ? distance : 0.0f);
+}
+
+void display_ui_set_stats(display_ui_t *ui, float mean, float p95, bool have)
+{
+    if (!have) {
+        ui->stats[0] = '\0';
+        return;
+    }
+    // Whole cm: the line must fit 128 px in the small font
+    snprintf(ui->stats, sizeof(ui->stats), "1h avg %d p95 %d", (int)(mean + 0.5f), (int)(p95 + 0.5f));
+}
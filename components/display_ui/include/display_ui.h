@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "oled_driver.h"
+#include "oled_widgets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Screen layout of display_task (128x64):
+ *
+ *     y  3  "Distance Logger"            title
+ *     y 13  trend sparkline, 16 rows     one column per sample
+ *     y 30  separator line
+ *     y 40  "Distance: 123.4 cm"
+ *     y 50  "Status: OK", or "1h avg 123 p95 210" once statistics are set
+ *     y 58  bar, 6 rows
+ *
+ * Kept out of main so the same screens can be rendered on the linux target
+ * (tools/oled_host) and compared against golden images.
+ */
+
+typedef struct {
+    oled_label_t title;
+    oled_sparkline_t trend;
+    oled_numeric_t distance;
+    oled_label_t status;
+    oled_bar_t bar;
+    char stats[OLED_WIDGET_TEXT_MAX];   // Status line for valid readings; empty = "Status: OK"
+} display_ui_t;
+
+/**
+ * @brief Set up the widgets (nothing is drawn)
+ *
+ * @param ui Layout state
+ */
+void display_ui_init(display_ui_t *ui);
+
+/**
+ * @brief Clear the screen and draw the static parts (title, separator), once after display_ui_init()
+ *
+ * Call inside a frame; the caller ends it.
+ *
+ * @param driver Driver handle
+ * @param ui Layout state
+ */
+void display_ui_draw_static(oled_driver_t *driver, display_ui_t *ui);
+
+/**
+ * @brief Scroll one sample into the trend graph
+ *
+ * @param driver Driver handle
+ * @param ui Layout state
+ * @param distance Distance in cm
+ * @param valid false for a sample out of range (drawn as a gap)
+ */
+void display_ui_push_sample(oled_driver_t *driver, display_ui_t *ui, float distance, bool valid);
+
+/**
+ * @brief Show the current reading (distance text, status, bar); unchanged widgets are not redrawn
+ *
+ * @param driver Driver handle
+ * @param ui Layout state
+ * @param distance Distance in cm
+ * @param valid false when the sensor is out of range
+ */
+void display_ui_show(oled_driver_t *driver, display_ui_t *ui, float distance, bool valid);
+
+/**
+ * @brief Set the statistics shown in the status line while the reading is valid
+ *
+ * Only stores the text; it appears on the next display_ui_show().
+ *
+ * @param ui Layout state
+ * @param mean Mean distance over the window in cm
+ * @param p95 95th percentile in cm
+ * @param have false while the window holds no valid reading (status line falls back to "Status: OK")
+ */
+void display_ui_set_stats(display_ui_t *ui, float mean, float p95, bool have);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,187 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "distance_hist.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "log_store.h"
+#include "dlog.h"
+
+static const char *TAG = "distance_hist";
+
+#define BIN_CM          CONFIG_DISTANCE_HIST_BIN_CM
+#define RETRY_US        (60 * 1000000LL)
+
+// Current and previous window of one length
+typedef struct {
+    uint32_t len_s;
+    uint32_t epoch[2];      // t / len_s of cur and prev
+    distance_hist_t hist[2];
+} level_t;
+
+enum { CUR, PREV };
+enum { LEVEL_HOUR, LEVEL_DAY, LEVELS };
+
+static level_t s_levels[LEVELS] = {
+    [LEVEL_HOUR] = { .len_s = 3600 },
+    [LEVEL_DAY] = { .len_s = 86400 },
+};
+static SemaphoreHandle_t s_lock;
+static StaticSemaphore_t s_lock_buf;
+
+// Completed day waiting for distance_hist_persist(); only touched by the feeding task
+static bool s_snapshot_pending;
+static int64_t s_next_try_us;
+
+static const char *const s_names[DISTANCE_HIST_WINDOWS] = {
+    [DISTANCE_HIST_HOUR] = "hour",
+    [DISTANCE_HIST_PREV_HOUR] = "prev_hour",
+    [DISTANCE_HIST_DAY] = "day",
+    [DISTANCE_HIST_PREV_DAY] = "prev_day",
+};
+
+esp_err_t distance_hist_init(void)
+{
+    s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+    return s_lock ? ESP_OK : ESP_FAIL;
+}
+
+// Called with the lock held: start a new window, the finished one becomes prev
+static void roll(level_t *lv, uint32_t epoch)
+{
+    lv->hist[PREV] = lv->hist[CUR];
+    lv->epoch[PREV] = lv->epoch[CUR];
+    memset(&lv->hist[CUR], 0, sizeof(lv->hist[CUR]));
+    lv->epoch[CUR] = epoch;
+}
+
+void distance_hist_add(const sample_ring_item_t *item)
+{
+    if (!s_lock) {
+        return;
+    }
+    uint32_t t_s = (uint32_t)(item->t_us / 1000000);
+    int bin = -1;
+    if (item->valid && item->distance >= 0.0f && item->distance < (float)CONFIG_DISTANCE_HIST_MAX_CM) {
+        bin = MIN((int)(item->distance / (float)BIN_CM), DISTANCE_HIST_BINS - 1);
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int l = 0; l < LEVELS; l++) {
+        level_t *lv = &s_levels[l];
+        uint32_t epoch = t_s / lv->len_s;
+        if (epoch != lv->epoch[CUR]) {
+            if (l == LEVEL_DAY && lv->hist[CUR].samples) {
+                s_snapshot_pending = true;
+                s_next_try_us = 0;
+            }
+            roll(lv, epoch);
+        }
+        distance_hist_t *h = &lv->hist[CUR];
+        h->samples++;
+        if (bin < 0) {
+            h->invalid++;
+        } else {
+            h->bins[bin]++;
+        }
+    }
+    xSemaphoreGive(s_lock);
+}
+
+esp_err_t distance_hist_get(distance_hist_window_t window, distance_hist_t *out)
+{
+    if ((unsigned)window >= DISTANCE_HIST_WINDOWS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const level_t *lv = &s_levels[window <= DISTANCE_HIST_PREV_HOUR ? LEVEL_HOUR : LEVEL_DAY];
+    bool prev = window == DISTANCE_HIST_PREV_HOUR || window == DISTANCE_HIST_PREV_DAY;
+    uint32_t now_epoch = (uint32_t)(esp_timer_get_time() / 1000000) / lv->len_s;
+    uint32_t want = prev ? now_epoch - 1 : now_epoch;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    // No reading since the boundary yet: the window is still in the cur slot
+    if (lv->epoch[CUR] == want && lv->hist[CUR].samples) {
+        *out = lv->hist[CUR];
+    } else if (lv->epoch[PREV] == want && lv->hist[PREV].samples) {
+        *out = lv->hist[PREV];
+    } else {
+        memset(out, 0, sizeof(*out));
+    }
+    xSemaphoreGive(s_lock);
+
+    out->window_s = lv->len_s;
+    out->start_ms = (int64_t)want * lv->len_s * 1000;
+    return ESP_OK;
+}
+
+void distance_hist_persist(void)
+{
+    if (!s_snapshot_pending || sizeof(CONFIG_DISTANCE_HIST_SNAPSHOT_FILE) <= 1) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    if (now < s_next_try_us) {
+        return;
+    }
+    // Static: 1.6 KB with the default bins. Only the feeding task rolls the day, so prev is stable here
+    static distance_hist_t day;
+    uint32_t epoch;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    day = s_levels[LEVEL_DAY].hist[PREV];
+    epoch = s_levels[LEVEL_DAY].epoch[PREV];
+    xSemaphoreGive(s_lock);
+
+    // One line per day: uptime day, samples, invalid, bin width, then every bin.
+    // The file sits next to the logs: open and close under their lock, only while the card is mounted
+    bool locked = log_store_card_lock();
+    FILE *f = locked ? fopen(CONFIG_DISTANCE_HIST_SNAPSHOT_FILE, "a") : NULL;
+    bool ok = f != NULL;
+    if (ok) {
+        fprintf(f, "%lu,%lu,%lu,%d", (unsigned long)epoch, (unsigned long)day.samples,
+                (unsigned long)day.invalid, BIN_CM);
+        for (int i = 0; i < DISTANCE_HIST_BINS; i++) {
+            fprintf(f, ",%lu", (unsigned long)day.bins[i]);
+        }
+        ok = fputc('\n', f) != EOF;
+        ok = fclose(f) == 0 && ok;
+    }
+    if (locked) {
+        log_store_fat_unlock();
+    }
+    if (!ok) {
+        ESP_LOGW(TAG, "Cannot append to %s, retrying in 60 s", CONFIG_DISTANCE_HIST_SNAPSHOT_FILE);
+        s_next_try_us = now + RETRY_US;
+        return;
+    }
+    s_snapshot_pending = false;
+    DLOGI(DLOG_MOD_SD, "hist: day %lu saved, %lu samples", DLOG_U(epoch), DLOG_U(day.samples));
+}
+
+const char *distance_hist_window_name(distance_hist_window_t window)
+{
+    if ((unsigned)window >= DISTANCE_HIST_WINDOWS) {
+        return "?";
+    }
+    return s_names[window];
+}
+
+distance_hist_window_t distance_hist_window_from_name(const char *name)
+{
+    for (int w = 0; w < DISTANCE_HIST_WINDOWS; w++) {
+        if (strcmp(name, s_names[w]) == 0) {
+            return (distance_hist_window_t)w;
+        }
+    }
+    return DISTANCE_HIST_WINDOWS;
+}
@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "sample_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed-bin distance histograms, one increment per sample.
+ *
+ * Windows are aligned to uptime (there is no wall clock): the current hour and day
+ * and the previous completed ones. Each completed day is appended to
+ * CONFIG_DISTANCE_HIST_SNAPSHOT_FILE by distance_hist_persist(), so a day's
+ * distribution is one small read instead of a scan over sensor.csv.
+ */
+
+typedef enum {
+    DISTANCE_HIST_HOUR,
+    DISTANCE_HIST_PREV_HOUR,
+    DISTANCE_HIST_DAY,
+    DISTANCE_HIST_PREV_DAY,
+    DISTANCE_HIST_WINDOWS
+} distance_hist_window_t;
+
+// Rounded up: when MAX_CM is not a multiple of BIN_CM the last bin is cut at MAX_CM
+#define DISTANCE_HIST_BINS ((CONFIG_DISTANCE_HIST_MAX_CM + CONFIG_DISTANCE_HIST_BIN_CM - 1) / \
+                            CONFIG_DISTANCE_HIST_BIN_CM)
+
+typedef struct {
+    uint32_t window_s;      // Window length
+    int64_t start_ms;       // Window start, ms since boot
+    uint32_t samples;       // Readings, including invalid ones
+    uint32_t invalid;       // Out of range, in no bin
+    uint32_t bins[DISTANCE_HIST_BINS];  // bins[i]: [i, i + 1) * CONFIG_DISTANCE_HIST_BIN_CM
+} distance_hist_t;
+
+// Static RAM taken by the four windows
+#define DISTANCE_HIST_RAM_BYTES (DISTANCE_HIST_WINDOWS * sizeof(distance_hist_t))
+
+/**
+ * @brief Create the lock; call once before the first distance_hist_add()
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t distance_hist_init(void);
+
+/**
+ * @brief Count one reading in the current hour and day
+ *
+ * @param item Sample from the sample ring (its t_us places it in time)
+ */
+void distance_hist_add(const sample_ring_item_t *item);
+
+/**
+ * @brief Copy one window as of now (empty if no reading fell into it)
+ *
+ * @param window Window
+ * @param out Histogram copy
+ * @return esp_err_t ESP_ERR_INVALID_ARG for an unknown window, ESP_ERR_INVALID_STATE before init
+ */
+esp_err_t distance_hist_get(distance_hist_window_t window, distance_hist_t *out);
+
+/**
+ * @brief Append the last completed day to the snapshot file if not done yet
+ *
+ * Call periodically from a task that may block on the SD card; a failed write is
+ * retried a minute later.
+ */
+void distance_hist_persist(void);
+
+/**
+ * @brief Window name as used in GET /hist ("hour", "prev_hour", "day", "prev_day")
+ */
+const char *distance_hist_window_name(distance_hist_window_t window);
+
+/**
+ * @brief Look up a window by name
+ *
+ * @return distance_hist_window_t Window, or DISTANCE_HIST_WINDOWS if not found
+ */
+distance_hist_window_t distance_hist_window_from_name(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
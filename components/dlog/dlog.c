@@ -0,0 +1,255 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "dlog.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "dlog";
+
+#define DLOG_RING_SIZE  CONFIG_DLOG_RING_RECORDS
+#define DLOG_RING_MASK  (DLOG_RING_SIZE - 1)
+
+_Static_assert((DLOG_RING_SIZE & DLOG_RING_MASK) == 0, "CONFIG_DLOG_RING_RECORDS must be a power of two");
+
+// Ring slot: seq is 0 while a writer fills the slot, index + 1 once committed
+typedef struct {
+    atomic_uint_least32_t seq;
+    dlog_record_t rec;
+} dlog_slot_t;
+
+_Static_assert(sizeof(dlog_slot_t) == DLOG_SLOT_BYTES, "DLOG_SLOT_BYTES out of date");
+
+static dlog_slot_t s_ring[DLOG_RING_SIZE];
+static atomic_uint_least32_t s_head;   // Next index to reserve
+_Static_assert(sizeof(s_ring) == DLOG_RAM_BYTES, "DLOG_RAM_BYTES out of date");
+
+uint8_t dlog_levels[DLOG_MOD_MAX] = {
+    [0 ... DLOG_MOD_MAX - 1] = CONFIG_DLOG_DEFAULT_LEVEL
+};
+
+static const char *const s_module_names[DLOG_MOD_MAX] = {
+    [DLOG_MOD_MAIN]    = "main",
+    [DLOG_MOD_SENSOR]  = "sensor",
+    [DLOG_MOD_SD]      = "sd",
+    [DLOG_MOD_LED]     = "led",
+    [DLOG_MOD_DISPLAY] = "display",
+    [DLOG_MOD_HTTP]    = "http",
+    [DLOG_MOD_UPLINK]  = "uplink",
+};
+
+void dlog_write(dlog_module_t module, esp_log_level_t level, const char *fmt,
+                size_t nargs, const uint32_t *args)
+{
+    uint32_t idx = atomic_fetch_add_explicit(&s_head, 1, memory_order_relaxed);
+    dlog_slot_t *slot = &s_ring[idx & DLOG_RING_MASK];
+
+    // Seqlock-style publish: readers that see seq change under them discard the copy
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->rec.timestamp_ms = esp_log_timestamp();
+    slot->rec.fmt = fmt;
+    slot->rec.module = (uint8_t)module;
+    slot->rec.level = (uint8_t)level;
+    slot->rec.nargs = (uint8_t)nargs;
+    for (size_t i = 0; i < nargs; i++) {
+        slot->rec.args[i] = args[i];
+    }
+
+    atomic_store_explicit(&slot->seq, idx + 1, memory_order_release);
+}
+
+void dlog_cursor_init(dlog_cursor_t *cursor, size_t backlog)
+{
+    uint32_t head = atomic_load_explicit(&s_head, memory_order_acquire);
+    if (backlog > DLOG_RING_SIZE) backlog = DLOG_RING_SIZE;
+    cursor->next = (head > backlog) ? head - (uint32_t)backlog : 0;
+    cursor->dropped = 0;
+}
+
+bool dlog_read(dlog_cursor_t *cursor, dlog_record_t *out)
+{
+    while (1) {
+        uint32_t head = atomic_load_explicit(&s_head, memory_order_acquire);
+        if (cursor->next == head) {
+            return false;
+        }
+        // Lapped by the writers: skip to the oldest record still in the ring
+        if (head - cursor->next > DLOG_RING_SIZE) {
+            cursor->dropped += head - DLOG_RING_SIZE - cursor->next;
+            cursor->next = head - DLOG_RING_SIZE;
+        }
+
+        dlog_slot_t *slot = &s_ring[cursor->next & DLOG_RING_MASK];
+        uint32_t want = cursor->next + 1;
+        uint32_t s1 = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (s1 == 0 || (int32_t)(s1 - want) < 0) {
+            // Reserved but not committed yet; try again on the next call
+            return false;
+        }
+        if (s1 != want) {
+            // Overwritten by a newer record
+            cursor->dropped++;
+            cursor->next++;
+            continue;
+        }
+
+        memcpy(out, &slot->rec, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        uint32_t s2 = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+        cursor->next++;
+        if (s2 != s1) {
+            cursor->dropped++;
+            continue;
+        }
+        if (out->nargs > DLOG_MAX_ARGS) out->nargs = DLOG_MAX_ARGS;
+        return true;
+    }
+}
+
+// Format one conversion spec (spec..end inclusive) with a raw argument word
+static int format_one(char *buf, size_t len, const char *spec, size_t spec_len, uint32_t arg)
+{
+    char one[16];
+    if (spec_len >= sizeof(one)) {
+        return snprintf(buf, len, "<?>");
+    }
+    memcpy(one, spec, spec_len);
+    one[spec_len] = '\0';
+
+    char conv = spec[spec_len - 1];
+    int longs = 0;
+    for (size_t i = 0; i < spec_len; i++) {
+        if (spec[i] == 'l') longs++;
+    }
+
+    union { uint32_t u; float f; } v = { .u = arg };
+    switch (conv) {
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            return snprintf(buf, len, one, (double)v.f);
+        case 'd': case 'i':
+            return longs ? snprintf(buf, len, one, (long)(int32_t)arg)
+                         : snprintf(buf, len, one, (int)(int32_t)arg);
+        case 'u': case 'x': case 'X': case 'o':
+            return longs ? snprintf(buf, len, one, (unsigned long)arg)
+                         : snprintf(buf, len, one, (unsigned int)arg);
+        case 'c':
+            return snprintf(buf, len, one, (int)arg);
+        default:
+            return snprintf(buf, len, "<?>");
+    }
+}
+
+int dlog_format(const dlog_record_t *record, char *buf, size_t len)
+{
+    if (!record || !buf || len == 0) {
+        return 0;
+    }
+
+    size_t pos = 0;
+    size_t argi = 0;
+    const char *p = record->fmt ? record->fmt : "";
+
+    while (*p && pos + 1 < len) {
+        if (*p != '%') {
+            buf[pos++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            buf[pos++] = '%';
+            p += 2;
+            continue;
+        }
+        // Find the conversion character
+        const char *spec = p++;
+        while (*p && strchr("-+ #0123456789.hlzjt", *p)) p++;
+        if (!*p) break;
+        size_t spec_len = (size_t)(p - spec) + 1;
+        p++;
+
+        uint32_t arg = (argi < record->nargs) ? record->args[argi] : 0;
+        argi++;
+        int n = format_one(buf + pos, len - pos, spec, spec_len, arg);
+        if (n < 0) break;
+        pos += ((size_t)n < len - pos) ? (size_t)n : len - pos - 1;
+    }
+    buf[pos] = '\0';
+    return (int)pos;
+}
+
+esp_err_t dlog_set_level(dlog_module_t module, esp_log_level_t level)
+{
+    if ((unsigned)module >= DLOG_MOD_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    dlog_levels[module] = (uint8_t)level;
+    return ESP_OK;
+}
+
+const char *dlog_module_name(dlog_module_t module)
+{
+    if ((unsigned)module >= DLOG_MOD_MAX) {
+        return "?";
+    }
+    return s_module_names[module];
+}
+
+dlog_module_t dlog_module_from_name(const char *name)
+{
+    for (int i = 0; i < DLOG_MOD_MAX; i++) {
+        if (strcmp(name, s_module_names[i]) == 0) {
+            return (dlog_module_t)i;
+        }
+    }
+    return DLOG_MOD_MAX;
+}
+
+#if CONFIG_DLOG_CONSOLE_TASK
+static StackType_t s_task_stack[CONFIG_DLOG_TASK_STACK_SIZE];
+static StaticTask_t s_task_tcb;
+
+static void dlog_task(void *pvParameters)
+{
+    static const char letters[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+    dlog_cursor_t cursor;
+    dlog_record_t rec;
+    char line[128];
+    uint32_t reported_drops = 0;
+
+    dlog_cursor_init(&cursor, DLOG_RING_SIZE);
+    while (1) {
+        while (dlog_read(&cursor, &rec)) {
+            dlog_format(&rec, line, sizeof(line));
+            esp_log_write((esp_log_level_t)rec.level, dlog_module_name(rec.module),
+                          "%c (%" PRIu32 ") %s: %s\n",
+                          letters[rec.level < sizeof(letters) ? rec.level : 0],
+                          rec.timestamp_ms, dlog_module_name(rec.module), line);
+        }
+        if (cursor.dropped != reported_drops) {
+            ESP_LOGW(TAG, "%" PRIu32 " records dropped (ring full)", cursor.dropped - reported_drops);
+            reported_drops = cursor.dropped;
+        }
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_DLOG_CONSOLE_PERIOD_MS));
+    }
+}
+#endif
+
+esp_err_t dlog_init(void)
+{
+#if CONFIG_DLOG_CONSOLE_TASK
+    // Lowest application priority: formatting and UART output never preempt sampling
+    if (!xTaskCreateStatic(dlog_task, "dlog_task", CONFIG_DLOG_TASK_STACK_SIZE, NULL, 1,
+                           s_task_stack, &s_task_tcb)) {
+        return ESP_FAIL;
+    }
+#endif
+    ESP_LOGI(TAG, "Deferred log ring: %d records", DLOG_RING_SIZE);
+    return ESP_OK;
+}
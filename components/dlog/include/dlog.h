@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Deferred binary logging.
+ *
+ * A DLOG call stores the format string pointer (the string stays in flash and
+ * doubles as the message ID) and up to DLOG_MAX_ARGS raw 32-bit arguments into
+ * a lock-free RAM ring. No formatting, no float math and no UART I/O happens on
+ * the caller's path; records are turned into text later by dlog_task or by the
+ * GET /logs handler.
+ *
+ * Arguments must be wrapped: DLOG_F() for float, DLOG_I()/DLOG_U() for integers.
+ * %s is not supported (the pointer may be gone by the time the record is read),
+ * %lld is not supported (arguments are 32 bits).
+ *
+ *     DLOGI(DLOG_MOD_SENSOR, "Distance: %.1f cm", DLOG_F(distance));
+ */
+
+#define DLOG_MAX_ARGS 4
+
+// Modules with their own runtime verbosity
+typedef enum {
+    DLOG_MOD_MAIN,
+    DLOG_MOD_SENSOR,
+    DLOG_MOD_SD,
+    DLOG_MOD_LED,
+    DLOG_MOD_DISPLAY,
+    DLOG_MOD_HTTP,
+    DLOG_MOD_UPLINK,
+    DLOG_MOD_MAX
+} dlog_module_t;
+
+// One log record as stored in the ring (28 bytes; 32 per ring slot with its sequence word)
+typedef struct {
+    uint32_t timestamp_ms;          // esp_log_timestamp() at the call
+    const char *fmt;                // Format string, also the message ID
+    uint8_t module;                 // dlog_module_t
+    uint8_t level;                  // esp_log_level_t
+    uint8_t nargs;                  // Number of valid args
+    uint8_t reserved;
+    uint32_t args[DLOG_MAX_ARGS];   // Raw argument words
+} dlog_record_t;
+
+// Reader position; every reader (console task, HTTP handler) owns one
+typedef struct {
+    uint32_t next;      // Index of the next record to read
+    uint32_t dropped;   // Records overwritten before this reader got to them
+} dlog_cursor_t;
+
+// Một slot của ring: sequence word + record, làm tròn theo alignment của record (con trỏ fmt)
+#define DLOG_SLOT_BYTES \
+    ((sizeof(uint32_t) + sizeof(dlog_record_t) + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *))
+
+// Static RAM taken by the ring (sequence word + record per slot)
+#define DLOG_RAM_BYTES (CONFIG_DLOG_RING_RECORDS * DLOG_SLOT_BYTES)
+
+// Per-module level table, read inline by the DLOG macros
+extern uint8_t dlog_levels[DLOG_MOD_MAX];
+
+static inline uint32_t dlog_float_bits(float v)
+{
+    union { float f; uint32_t u; } c = { .f = v };
+    return c.u;
+}
+
+#define DLOG_F(v) dlog_float_bits((float)(v))
+#define DLOG_I(v) ((uint32_t)(int32_t)(v))
+#define DLOG_U(v) ((uint32_t)(v))
+
+#define DLOG(mod, lvl, fmt, ...) do {                                               \
+        if ((lvl) <= dlog_levels[(mod)]) {                                          \
+            const uint32_t dlog_args_[] = { 0, ##__VA_ARGS__ };                     \
+            _Static_assert(sizeof(dlog_args_) / sizeof(uint32_t) - 1 <= DLOG_MAX_ARGS, \
+                           "too many DLOG arguments");                              \
+            dlog_write((mod), (lvl), (fmt),                                         \
+                       sizeof(dlog_args_) / sizeof(uint32_t) - 1, &dlog_args_[1]);  \
+        }                                                                           \
+    } while (0)
+
+#define DLOGE(mod, fmt, ...) DLOG(mod, ESP_LOG_ERROR, fmt, ##__VA_ARGS__)
+#define DLOGW(mod, fmt, ...) DLOG(mod, ESP_LOG_WARN, fmt, ##__VA_ARGS__)
+#define DLOGI(mod, fmt, ...) DLOG(mod, ESP_LOG_INFO, fmt, ##__VA_ARGS__)
+#define DLOGD(mod, fmt, ...) DLOG(mod, ESP_LOG_DEBUG, fmt, ##__VA_ARGS__)
+
+/**
+ * @brief Start the console drain task (if enabled in menuconfig)
+ *
+ * Logging works before this is called; records simply accumulate in the ring.
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t dlog_init(void);
+
+/**
+ * @brief Append a record to the ring (use the DLOG macros instead)
+ *
+ * @param module Module ID
+ * @param level Record level
+ * @param fmt Format string with static storage duration
+ * @param nargs Number of argument words
+ * @param args Argument words
+ */
+void dlog_write(dlog_module_t module, esp_log_level_t level, const char *fmt,
+                size_t nargs, const uint32_t *args);
+
+/**
+ * @brief Position a cursor so that at most @p backlog existing records are read
+ *
+ * @param cursor Cursor to initialise
+ * @param backlog Number of most recent records to include (0 = only new ones)
+ */
+void dlog_cursor_init(dlog_cursor_t *cursor, size_t backlog);
+
+/**
+ * @brief Copy the next committed record without consuming it for other readers
+ *
+ * @param cursor Reader cursor
+ * @param out Record copy
+ * @return true if a record was returned, false if the reader is caught up
+ */
+bool dlog_read(dlog_cursor_t *cursor, dlog_record_t *out);
+
+/**
+ * @brief Format a record's message (without prefix) into a buffer
+ *
+ * @param record Record to format
+ * @param buf Output buffer
+ * @param len Buffer size
+ * @return int Number of characters written (excluding terminator)
+ */
+int dlog_format(const dlog_record_t *record, char *buf, size_t len);
+
+/**
+ * @brief Set the runtime level of one module
+ *
+ * @param module Module ID
+ * @param level New level
+ * @return esp_err_t ESP_ERR_INVALID_ARG for an unknown module
+ */
+esp_err_t dlog_set_level(dlog_module_t module, esp_log_level_t level);
+
+/**
+ * @brief Module name as used in output and in the /logs/level query
+ */
+const char *dlog_module_name(dlog_module_t module);
+
+/**
+ * @brief Look up a module by name
+ *
+ * @return dlog_module_t Module ID, or DLOG_MOD_MAX if not found
+ */
+dlog_module_t dlog_module_from_name(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
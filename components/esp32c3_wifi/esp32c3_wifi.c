@@ -7,6 +7,8 @@
    CONDITIONS OF ANY KIND, either express or implied.
 */
 #include <string.h>
+#include <stddef.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
@@ -15,6 +17,13 @@
 #include "esp_event.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
+#include "nvs.h"
+#include "esp_attr.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "boot_prof.h"
+#include "esp32c3_wifi.h"
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
@@ -28,7 +37,6 @@
 */
 #define EXAMPLE_ESP_WIFI_SSID      "4 chi em"
 #define EXAMPLE_ESP_WIFI_PASS      "daytro6868"
-#define EXAMPLE_ESP_MAXIMUM_RETRY  5
 
 #if CONFIG_ESP_STATION_EXAMPLE_WPA3_SAE_PWE_HUNT_AND_PECK
 #define ESP_WIFI_SAE_MODE WPA3_SAE_PWE_HUNT_AND_PECK
@@ -62,39 +70,231 @@
 /* FreeRTOS event group to signal when we are connected*/
 static EventGroupHandle_t s_wifi_event_group;
 
-/* The event group allows multiple bits for each event, but we only care about two events:
- * - we are connected to the AP with an IP
- * - we failed to connect after the maximum amount of retries */
 #define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT      BIT1
 
 static const char *TAG = "wifi station";
 
-static int s_retry_num = 0;
+// Last AP that gave us an address. RTC copy survives a software reset or brown-out
+// reboot without touching flash; the NVS copy survives power loss.
+#define WIFI_CACHE_MAGIC 0x57434331u    // "WCC1"
+typedef struct {
+    uint32_t magic;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    uint32_t ip;                        // Last lease (informational; lwIP restores it itself)
+    uint32_t crc;                       // Over the fields above
+} wifi_ap_cache_t;
+
+#define WIFI_NVS_NAMESPACE "wifi_cache"
+#define WIFI_NVS_KEY       "ap"
+
+static RTC_NOINIT_ATTR wifi_ap_cache_t s_rtc_cache;
+static wifi_ap_cache_t s_cache;
+static bool s_cache_valid = false;
+
+static esp_timer_handle_t s_reconnect_timer;
+static int s_backoff_level = 0;
+static int s_cache_failures = 0;
+static bool s_target_is_cache = false;  // What the current wifi_config points at
+static int64_t s_start_us;              // esp_wifi_start()
+static int64_t s_attempt_us;            // Last esp_wifi_connect()
+static int64_t s_outage_us;             // Link lost (0 while connected)
+
+static wifi_metrics_t s_metrics;
+static portMUX_TYPE s_metrics_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t cache_crc(const wifi_ap_cache_t *c)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)c, offsetof(wifi_ap_cache_t, crc));
+}
+
+static bool cache_ok(const wifi_ap_cache_t *c)
+{
+    return c->magic == WIFI_CACHE_MAGIC && c->channel >= 1 && c->channel <= 14 && c->crc == cache_crc(c);
+}
+
+// RTC first (no flash read after a warm reset), then NVS
+static void cache_load(void)
+{
+    if (cache_ok(&s_rtc_cache)) {
+        s_cache = s_rtc_cache;
+        s_cache_valid = true;
+        ESP_LOGI(TAG, "AP cache from RTC: channel %u", s_cache.channel);
+        return;
+    }
+    nvs_handle_t nvs;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;
+    }
+    size_t len = sizeof(s_cache);
+    if (nvs_get_blob(nvs, WIFI_NVS_KEY, &s_cache, &len) == ESP_OK && len == sizeof(s_cache) && cache_ok(&s_cache)) {
+        s_cache_valid = true;
+        s_rtc_cache = s_cache;
+        ESP_LOGI(TAG, "AP cache from NVS: channel %u", s_cache.channel);
+    }
+    nvs_close(nvs);
+}
+
+// Called on GOT_IP; NVS is only written when the AP, channel or lease changed
+static void cache_store(uint32_t ip)
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+    wifi_ap_cache_t c = { .magic = WIFI_CACHE_MAGIC, .channel = ap.primary, .ip = ip };
+    memcpy(c.bssid, ap.bssid, sizeof(c.bssid));
+    c.crc = cache_crc(&c);
+    s_rtc_cache = c;
+    if (s_cache_valid && memcmp(&c, &s_cache, sizeof(c)) == 0) {
+        return;
+    }
+    s_cache = c;
+    s_cache_valid = true;
 
+    nvs_handle_t nvs;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+        if (nvs_set_blob(nvs, WIFI_NVS_KEY, &c, sizeof(c)) == ESP_OK) {
+            nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    ESP_LOGI(TAG, "AP cache updated: " MACSTR " channel %u", MAC2STR(c.bssid), c.channel);
+}
+
+// Point the station config at the cached AP (targeted connect) or at any AP with our SSID
+static void set_target(bool use_cache)
+{
+    wifi_config_t cfg;
+    if (esp_wifi_get_config(WIFI_IF_STA, &cfg) != ESP_OK) {
+        return;
+    }
+    if (use_cache) {
+        cfg.sta.bssid_set = true;
+        memcpy(cfg.sta.bssid, s_cache.bssid, sizeof(cfg.sta.bssid));
+        cfg.sta.channel = s_cache.channel;
+        cfg.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        cfg.sta.bssid_set = false;
+        cfg.sta.channel = 0;
+        cfg.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        cfg.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+    esp_wifi_set_config(WIFI_IF_STA, &cfg);
+    s_target_is_cache = use_cache;
+}
+
+static void start_attempt(void)
+{
+#if CONFIG_WIFI_FAST_CONNECT
+    bool use_cache = s_cache_valid && s_cache_failures < CONFIG_WIFI_CACHE_ATTEMPTS;
+#else
+    bool use_cache = false;
+#endif
+    if (use_cache != s_target_is_cache) {
+        set_target(use_cache);
+    }
+    s_attempt_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_metrics_lock);
+    s_metrics.attempts++;
+    if (!use_cache) {
+        s_metrics.full_scans++;
+    }
+    portEXIT_CRITICAL(&s_metrics_lock);
+    esp_wifi_connect();
+}
+
+static void reconnect_timer_cb(void *arg)
+{
+    start_attempt();
+}
+
+// min * 2^level capped at max, upper half randomised ("equal jitter")
+static uint32_t backoff_ms(int level)
+{
+    uint32_t delay = CONFIG_WIFI_BACKOFF_MIN_MS;
+    for (int i = 0; i < level && delay < CONFIG_WIFI_BACKOFF_MAX_MS; i++) {
+        delay *= 2;
+    }
+    if (delay > CONFIG_WIFI_BACKOFF_MAX_MS) {
+        delay = CONFIG_WIFI_BACKOFF_MAX_MS;
+    }
+    return delay / 2 + esp_random() % (delay / 2 + 1);
+}
 
 static void event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data)
 {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
+        start_attempt();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (s_retry_num < EXAMPLE_ESP_MAXIMUM_RETRY) {
-            esp_wifi_connect();
-            s_retry_num++;
-            ESP_LOGI(TAG, "retry to connect to the AP");
+        wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t *)event_data;
+        int64_t now = esp_timer_get_time();
+        bool was_connected = xEventGroupGetBits(s_wifi_event_group) & WIFI_CONNECTED_BIT;
+        xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        if (was_connected) {
+            s_outage_us = now;
+        }
+        if (s_target_is_cache) {
+            s_cache_failures++;
         } else {
-            xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+            // Full scan failed too: give the cached AP another go next time (it may just be rebooting)
+            s_cache_failures = 0;
         }
-        ESP_LOGI(TAG,"connect to the AP fail");
+
+        uint32_t delay = backoff_ms(s_backoff_level);
+        if (s_backoff_level < 16) s_backoff_level++;
+        portENTER_CRITICAL(&s_metrics_lock);
+        if (was_connected) s_metrics.disconnects++;
+        s_metrics.last_reason = event->reason;
+        s_metrics.backoff_level = (uint8_t)s_backoff_level;
+        s_metrics.connected = false;
+        portEXIT_CRITICAL(&s_metrics_lock);
+
+        ESP_LOGI(TAG, "disconnected (reason %u, %s), retry in %" PRIu32 " ms", event->reason,
+                 s_target_is_cache ? "cached AP" : "full scan", delay);
+        esp_timer_stop(s_reconnect_timer);
+        esp_timer_start_once(s_reconnect_timer, (uint64_t)delay * 1000);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
-        ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
-        s_retry_num = 0;
+        int64_t now = esp_timer_get_time();
+        ESP_LOGI(TAG, "got ip:" IPSTR " in %" PRIu32 " ms (%s)", IP2STR(&event->ip_info.ip),
+                 (uint32_t)((now - s_attempt_us) / 1000), s_target_is_cache ? "cached AP" : "full scan");
+        boot_prof_mark(BOOT_PHASE_GOT_IP);
+
+        portENTER_CRITICAL(&s_metrics_lock);
+        s_metrics.connects++;
+        if (s_target_is_cache) s_metrics.cache_connects++;
+        s_metrics.last_connect_ms = (uint32_t)((now - s_attempt_us) / 1000);
+        if (s_metrics.connects == 1) {
+            s_metrics.boot_connect_ms = (uint32_t)((now - s_start_us) / 1000);
+        }
+        if (s_outage_us) {
+            s_metrics.last_outage_ms = (uint32_t)((now - s_outage_us) / 1000);
+            if (s_metrics.last_outage_ms > s_metrics.max_outage_ms) {
+                s_metrics.max_outage_ms = s_metrics.last_outage_ms;
+            }
+        }
+        s_metrics.backoff_level = 0;
+        s_metrics.connected = true;
+        portEXIT_CRITICAL(&s_metrics_lock);
+
+        s_outage_us = 0;
+        s_backoff_level = 0;
+        s_cache_failures = 0;
+        cache_store(event->ip_info.ip.addr);
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
 }
 
+void wifi_get_metrics(wifi_metrics_t *out)
+{
+    portENTER_CRITICAL(&s_metrics_lock);
+    *out = s_metrics;
+    portEXIT_CRITICAL(&s_metrics_lock);
+}
+
 void wifi_init_sta(void)
 {
     //Initialize NVS
@@ -104,6 +304,7 @@ void wifi_init_sta(void)
       ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    cache_load();
 
     if (CONFIG_LOG_MAXIMUM_LEVEL > CONFIG_LOG_DEFAULT_LEVEL) {
         /* If you only want to open more logs in the wifi module, you need to make the max level greater than the default level,
@@ -117,9 +318,19 @@ void wifi_init_sta(void)
 
     ESP_ERROR_CHECK(esp_netif_init());
 
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    // The application may have created the loop already to register its own IP handlers
+    ret = esp_event_loop_create_default();
+    if (ret != ESP_ERR_INVALID_STATE) {
+        ESP_ERROR_CHECK(ret);
+    }
     esp_netif_create_default_wifi_sta();
 
+    const esp_timer_create_args_t timer_args = {
+        .callback = reconnect_timer_cb,
+        .name = "wifi_reconnect",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_reconnect_timer));
+
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
 
@@ -152,29 +363,14 @@ void wifi_init_sta(void)
     };
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA) );
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config) );
+    s_start_us = esp_timer_get_time();
     ESP_ERROR_CHECK(esp_wifi_start() );
 
-    ESP_LOGI(TAG, "wifi_init_sta finished.");
-
-    /* Waiting until either the connection is established (WIFI_CONNECTED_BIT) or connection failed for the maximum
-     * number of re-tries (WIFI_FAIL_BIT). The bits are set by event_handler() (see above) */
-    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-            WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-            pdFALSE,
-            pdFALSE,
-            portMAX_DELAY);
-
-    /* xEventGroupWaitBits() returns the bits before the call returned, hence we can test which event actually
-     * happened. */
-    if (bits & WIFI_CONNECTED_BIT) {
-        ESP_LOGI(TAG, "connected to ap SSID:%s password:%s",
-                 EXAMPLE_ESP_WIFI_SSID, EXAMPLE_ESP_WIFI_PASS);
-    } else if (bits & WIFI_FAIL_BIT) {
-        ESP_LOGI(TAG, "Failed to connect to SSID:%s, password:%s",
-                 EXAMPLE_ESP_WIFI_SSID, EXAMPLE_ESP_WIFI_PASS);
-    } else {
-        ESP_LOGE(TAG, "UNEXPECTED EVENT");
-    }
+    boot_prof_mark(BOOT_PHASE_WIFI_STARTED);
+
+    // No wait here: the connection completes in the background and IP_EVENT_STA_GOT_IP
+    // tells interested components (the HTTP server) when the network is usable
+    ESP_LOGI(TAG, "wifi_init_sta finished, connecting to SSID:%s", EXAMPLE_ESP_WIFI_SSID);
 }
 
 // void app_main(void)
@@ -1,7 +1,40 @@
 #ifndef __ESP32C3_WIFI_H__
 #define __ESP32C3_WIFI_H__
 
+#include <stdint.h>
+#include <stdbool.h>
+
+// Connection counters; times in ms
+typedef struct {
+    uint32_t attempts;          // esp_wifi_connect() calls
+    uint32_t connects;          // IP_EVENT_STA_GOT_IP events
+    uint32_t disconnects;       // Links lost after having an address
+    uint32_t cache_connects;    // Connects that used the cached BSSID/channel
+    uint32_t full_scans;        // Attempts that scanned all channels
+    uint32_t boot_connect_ms;   // esp_wifi_start() to the first address
+    uint32_t last_connect_ms;   // Last successful attempt: esp_wifi_connect() to address
+    uint32_t last_outage_ms;    // Last link loss to address again
+    uint32_t max_outage_ms;
+    uint16_t last_reason;       // wifi_err_reason_t of the last disconnect event
+    uint8_t backoff_level;      // Consecutive failed attempts (capped)
+    bool connected;
+} wifi_metrics_t;
+
+/**
+ * @brief Start the station and return without waiting for the connection
+ *
+ * Creates the default event loop unless the application already did. Wait for
+ * IP_EVENT_STA_GOT_IP before using the network. Failed or lost connections are
+ * retried forever with exponential backoff; the cached AP is tried first.
+ */
 void wifi_init_sta(void);
+
+/**
+ * @brief Copy the connection counters
+ *
+ * @param out Destination
+ */
+void wifi_get_metrics(wifi_metrics_t *out);
 // void wifi_init_ap(void);
 
 #endif
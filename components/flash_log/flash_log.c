@@ -0,0 +1,280 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "flash_log.h"
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_littlefs.h"
+#include "dlog.h"
+
+static const char *TAG = "flash_log";
+
+#define LOG_DIR         FLASH_LOG_MOUNT_POINT "/log"
+#define SEGMENT_BYTES   ((long)CONFIG_FLASH_LOG_SEGMENT_KB * 1024)
+#define RECORD_HEADER   3
+#define BATCH_BYTES     CONFIG_FLASH_LOG_BATCH_BYTES
+#define BATCH_MAX_US    ((int64_t)CONFIG_FLASH_LOG_BATCH_MAX_S * 1000000)
+
+_Static_assert(BATCH_BYTES >= RECORD_HEADER + CONFIG_LOG_STORE_TAIL_BYTES,
+               "CONFIG_FLASH_LOG_BATCH_BYTES must hold a full log_store tail");
+_Static_assert(BATCH_BYTES <= CONFIG_FLASH_LOG_SEGMENT_KB * 1024,
+               "CONFIG_FLASH_LOG_BATCH_BYTES larger than a segment");
+
+typedef struct {
+    log_backend_t base;     // First member: log_store only sees a log_backend_t
+    uint32_t first;         // Oldest segment
+    uint32_t cur;           // Segment being written; first..cur exist (cur may be empty)
+    FILE *f;                // Handle on cur, NULL until the next append
+    long cur_size;          // Bytes in cur
+    long drained;           // Bytes of first already moved to the card (a retry skips them)
+    size_t batch_len;       // Records in s_batch, newer than everything in the segments
+    int64_t batch_us;       // Time the oldest of them was taken
+    flash_log_stats_t stats;
+} flash_log_t;
+
+static flash_log_t s_log;
+static char s_record[CONFIG_LOG_STORE_TAIL_BYTES];
+// Records collected in RAM and written to flash one block at a time
+static uint8_t s_batch[BATCH_BYTES];
+
+static void segment_path(uint32_t n, char *path, size_t len)
+{
+    snprintf(path, len, LOG_DIR "/%08lx.seg", (unsigned long)n);
+}
+
+// Start a new segment; the old one is complete (or ends in a torn record nobody appends after)
+static void next_segment(flash_log_t *log)
+{
+    if (log->f) {
+        fclose(log->f);
+        log->f = NULL;
+    }
+    log->cur++;
+    log->cur_size = 0;
+}
+
+// Full log: the oldest rows go, the erase lands on the blocks they used
+static void drop_oldest(flash_log_t *log)
+{
+    char path[40];
+    segment_path(log->first, path, sizeof(path));
+    struct stat st;
+    if (stat(path, &st) == 0 && st.st_size > log->drained) {
+        log->stats.overwritten += (uint32_t)(st.st_size - log->drained);
+    }
+    unlink(path);
+    log->first++;
+    log->drained = 0;
+    DLOGW(DLOG_MOD_SD, "flash_log full: dropped segment %u", DLOG_U(log->first - 1));
+}
+
+// Write the collected records to the current segment: one write + fsync per batch
+static esp_err_t batch_write(flash_log_t *log)
+{
+    if (log->batch_len == 0) {
+        return ESP_OK;
+    }
+    if (log->cur_size > 0 && log->cur_size + (long)log->batch_len > SEGMENT_BYTES) {
+        next_segment(log);
+    }
+    while (log->cur - log->first + 1 > log->stats.max_segments) {
+        drop_oldest(log);
+    }
+    if (!log->f) {
+        char path[40];
+        segment_path(log->cur, path, sizeof(path));
+        log->f = fopen(path, "a");
+        if (!log->f) {
+            DLOGE(DLOG_MOD_SD, "flash_log: cannot open segment %u", DLOG_U(log->cur));
+            return ESP_FAIL;
+        }
+    }
+    bool ok = fwrite(s_batch, 1, log->batch_len, log->f) == log->batch_len &&
+              fflush(log->f) == 0 && fsync(fileno(log->f)) == 0;
+    if (!ok) {
+        // What reached the file ends in a torn record: the batch is retried in a new segment
+        next_segment(log);
+        DLOGE(DLOG_MOD_SD, "flash_log: write of %u bytes failed", DLOG_U(log->batch_len));
+        return ESP_FAIL;
+    }
+    log->cur_size += (long)log->batch_len;
+    log->batch_len = 0;
+    log->stats.writes++;
+    return ESP_OK;
+}
+
+static esp_err_t flash_append(log_backend_t *be, log_store_file_t file, const char *data, size_t len)
+{
+    flash_log_t *log = (flash_log_t *)be;
+    size_t rec = RECORD_HEADER + len;
+    if (len > sizeof(s_record)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // Full batch: write it out first; if that fails the rows stay in the log_store tail
+    if (log->batch_len + rec > sizeof(s_batch) && batch_write(log) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    int64_t now = esp_timer_get_time();
+    if (log->batch_len == 0) {
+        log->batch_us = now;
+    }
+    uint8_t *p = s_batch + log->batch_len;
+    p[0] = (uint8_t)file;
+    p[1] = (uint8_t)len;
+    p[2] = (uint8_t)(len >> 8);
+    memcpy(p + RECORD_HEADER, data, len);
+    log->batch_len += rec;
+    log->stats.appended += (uint32_t)len;
+    // Bounds what a power cut loses; a failed write is retried with the next append
+    if (now - log->batch_us >= BATCH_MAX_US) {
+        batch_write(log);
+    }
+    return ESP_OK;
+}
+
+static bool flash_pending(log_backend_t *be)
+{
+    flash_log_t *log = (flash_log_t *)be;
+    return log->first != log->cur || log->cur_size > 0 || log->batch_len > 0;
+}
+
+// Nothing in the segments: the records still in RAM go straight to the card, never to flash
+static esp_err_t batch_drain(flash_log_t *log, log_backend_t *to)
+{
+    size_t off = 0;
+    esp_err_t err = ESP_OK;
+    while (off < log->batch_len) {
+        const uint8_t *p = s_batch + off;
+        size_t len = p[1] | ((size_t)p[2] << 8);
+        err = to->append(to, (log_store_file_t)p[0], (const char *)p + RECORD_HEADER, len);
+        if (err != ESP_OK) {
+            break;
+        }
+        off += RECORD_HEADER + len;
+        log->stats.migrated += (uint32_t)len;
+    }
+    memmove(s_batch, s_batch + off, log->batch_len - off);
+    log->batch_len -= off;
+    return err;
+}
+
+static esp_err_t flash_drain(log_backend_t *be, log_backend_t *to)
+{
+    flash_log_t *log = (flash_log_t *)be;
+    if (!flash_pending(be)) {
+        return ESP_OK;
+    }
+    if (log->first == log->cur && log->cur_size == 0) {
+        return batch_drain(log, to);
+    }
+    if (log->first == log->cur) {
+        next_segment(log);  // Drain the one being written; new rows go to the next
+    }
+    char path[40];
+    segment_path(log->first, path, sizeof(path));
+    FILE *f = fopen(path, "r");
+    if (f && fseek(f, log->drained, SEEK_SET) == 0) {
+        uint8_t header[RECORD_HEADER];
+        while (fread(header, 1, sizeof(header), f) == sizeof(header)) {
+            size_t len = header[1] | ((size_t)header[2] << 8);
+            // A torn or foreign record ends the segment
+            if (header[0] >= LOG_STORE_FILES || len > sizeof(s_record) || fread(s_record, 1, len, f) != len) {
+                break;
+            }
+            esp_err_t err = to->append(to, (log_store_file_t)header[0], s_record, len);
+            if (err != ESP_OK) {
+                fclose(f);
+                return err;     // Resumes at this record
+            }
+            log->drained += RECORD_HEADER + (long)len;
+            log->stats.migrated += (uint32_t)len;
+        }
+    }
+    if (f) {
+        fclose(f);
+    }
+    // A crash before this unlink moves the whole segment again on the next boot (duplicate rows)
+    unlink(path);
+    log->first++;
+    log->drained = 0;
+    return ESP_OK;
+}
+
+// Segments of a previous boot: first..last by number; writing resumes in a fresh one
+static void scan_segments(flash_log_t *log)
+{
+    bool any = false;
+    uint32_t lo = 0, hi = 0;
+    DIR *dir = opendir(LOG_DIR);
+    if (dir) {
+        struct dirent *e;
+        while ((e = readdir(dir)) != NULL) {
+            char *end;
+            unsigned long n = strtoul(e->d_name, &end, 16);
+            if (end == e->d_name || strcmp(end, ".seg") != 0) {
+                continue;
+            }
+            if (!any || n < lo) {
+                lo = (uint32_t)n;
+            }
+            if (!any || n > hi) {
+                hi = (uint32_t)n;
+            }
+            any = true;
+        }
+        closedir(dir);
+    }
+    log->first = any ? lo : 0;
+    log->cur = any ? hi + 1 : 0;
+    log->cur_size = 0;
+    log->drained = 0;
+    log->batch_len = 0;
+}
+
+esp_err_t flash_log_init(log_backend_t **backend)
+{
+    esp_vfs_littlefs_conf_t conf = {
+        .base_path = FLASH_LOG_MOUNT_POINT,
+        .partition_label = CONFIG_FLASH_LOG_PARTITION,
+        .format_if_mount_failed = true,
+    };
+    esp_err_t err = esp_vfs_littlefs_register(&conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Mount of partition %s failed: %s", CONFIG_FLASH_LOG_PARTITION, esp_err_to_name(err));
+        return err;
+    }
+    size_t total = 0, used = 0;
+    esp_littlefs_info(CONFIG_FLASH_LOG_PARTITION, &total, &used);
+    mkdir(LOG_DIR, 0775);
+
+    flash_log_t *log = &s_log;
+    log->base.name = "flash";
+    log->base.append = flash_append;
+    log->base.drain = flash_drain;
+    log->base.pending = flash_pending;
+    log->stats.max_segments = (uint32_t)(total / 100 * CONFIG_FLASH_LOG_FILL_PCT / SEGMENT_BYTES);
+    if (log->stats.max_segments < 2) {
+        log->stats.max_segments = 2;
+    }
+    scan_segments(log);
+    ESP_LOGI(TAG, "%u KB partition, %" PRIu32 " segments of %d KB, %" PRIu32 " left to move to the card",
+             (unsigned)(total / 1024), log->stats.max_segments, CONFIG_FLASH_LOG_SEGMENT_KB,
+             log->cur - log->first);
+    *backend = &log->base;
+    return ESP_OK;
+}
+
+void flash_log_get_stats(flash_log_stats_t *out)
+{
+    *out = s_log.stats;
+    out->segments = s_log.cur - s_log.first + (s_log.cur_size > 0);
+}
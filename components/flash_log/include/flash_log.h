@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "log_store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fallback backend of log_store: a circular log on a LittleFS partition in the
+ * internal flash, used while the SD card is missing or failing.
+ *
+ * Rows are stored as records [file id][length, 16 bit LE][bytes] in segment files
+ * /flash/log/<n>.seg of CONFIG_FLASH_LOG_SEGMENT_KB. Writes only ever append, and a
+ * full log deletes its oldest segment, so erases rotate over the whole partition.
+ * Segments left by a previous boot are moved back to the card like any other.
+ *
+ * Records are collected in RAM and written CONFIG_FLASH_LOG_BATCH_BYTES (one
+ * LittleFS block) at a time, or once the oldest is CONFIG_FLASH_LOG_BATCH_MAX_S old,
+ * instead of one program + fsync per log_store commit. A power cut while the card
+ * is out loses the batch; a card that comes back takes it straight from RAM.
+ */
+
+// Where the partition is mounted; static web files live in FLASH_LOG_MOUNT_POINT "/www"
+#define FLASH_LOG_MOUNT_POINT "/flash"
+
+typedef struct {
+    uint32_t segments;      // Segments held, including the one being written
+    uint32_t max_segments;  // Capacity (CONFIG_FLASH_LOG_FILL_PCT of the partition)
+    uint32_t appended;      // Row bytes taken since boot (in the RAM batch or in flash)
+    uint32_t migrated;      // Row bytes moved back to the card since boot
+    uint32_t overwritten;   // Segment bytes dropped because the log was full
+    uint32_t writes;        // Batches written to flash since boot
+} flash_log_stats_t;
+
+// Static RAM: the write batch and one record buffer for moving rows back to the card
+#define FLASH_LOG_RAM_BYTES (CONFIG_FLASH_LOG_BATCH_BYTES + CONFIG_LOG_STORE_TAIL_BYTES + 64)
+
+/**
+ * @brief Mount the partition and pick up segments left by a previous boot
+ *
+ * @param[out] backend Backend to pass to log_store_set_fallback()
+ * @return esp_err_t ESP_OK on success, error from the LittleFS mount otherwise
+ */
+esp_err_t flash_log_init(log_backend_t **backend);
+
+/**
+ * @brief Copy the counters (any task; they may be one commit apart)
+ */
+void flash_log_get_stats(flash_log_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
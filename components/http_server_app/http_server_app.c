@@ -9,23 +9,37 @@
    CONDITIONS OF ANY KIND, either express or implied.
 */
 
-// #include <string.h>
-// #include <stdlib.h>
-// #include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdio.h>
 #include <esp_log.h>
 #include <stdbool.h>
 #include <sys/param.h>
-#include "esp_netif.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include "esp_event.h"
-#include "esp_netif.h"
 #include "esp_http_server.h"
-#include "driver/gpio.h"
 #include "esp_timer.h"
-#include "ultrasonic_sensor.h"
+#include "dlog.h"
+#include "sample_trace.h"
+#include "boot_prof.h"
+#include "sample_batch.h"
+#include "log_store.h"
+#include "sample_stats.h"
+#include "distance_hist.h"
+#include "occupancy.h"
+#include "approach_tracker.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "sys_monitor.h"
+#include "esp32c3_wifi.h"
+#include "sd_card_spi.h"
+#include "flash_log.h"
+#endif
 #define EXAMPLE_HTTP_QUERY_KEY_MAX_LEN  (64)
 
-#define MOUNT_POINT "/sdcard"
-
 /* A simple example that demonstrates how to create GET and POST
  * handlers for the web server.
  */
@@ -34,13 +48,72 @@ static const char *TAG = "example";
 static httpd_handle_t server = NULL;
 #define LED_PIN 2
 extern volatile int g_led_status;
-extern QueueHandle_t distance_queue;
 extern const uint8_t index_html_start[] asm("_binary_index_html_start");
 extern const uint8_t index_html_end[] asm("_binary_index_html_end");
 // Read-only access to latest distance without consuming queue
 extern float g_distance;
 extern bool g_distance_valid;
+extern volatile uint32_t g_distance_seq;
+
 
+#define PROTOBUF_CONTENT_TYPE "application/x-protobuf"
+
+// ?format=pb or "Accept: application/x-protobuf" selects the smart_embed.proto encoding;
+// JSON stays the default for the web page
+static bool want_protobuf(httpd_req_t *req)
+{
+    char val[32];
+    char query[EXAMPLE_HTTP_QUERY_KEY_MAX_LEN] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "format", val, sizeof(val)) == ESP_OK) {
+        return strcmp(val, "pb") == 0;
+    }
+    return httpd_req_get_hdr_value_str(req, "Accept", val, sizeof(val)) == ESP_OK &&
+           strstr(val, PROTOBUF_CONTENT_TYPE) != NULL;
+}
+
+// History as a stream of length-delimited Batch messages (255 rows each); seq counts rows
+static void send_history_pb(httpd_req_t *req, log_store_reader_t *r)
+{
+    static uint8_t batch_buf[SAMPLE_BATCH_BYTES(SAMPLE_BATCH_MAX_SAMPLES)];
+    static sample_batch_t batch;
+    uint8_t prefix[SAMPLE_PB_DELIMITER_MAX_BYTES];
+    uint32_t batch_seq = 0;
+    sample_ring_item_t item = { .valid = true };
+    char line[128];
+
+    httpd_resp_set_type(req, PROTOBUF_CONTENT_TYPE);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    sample_batch_init(&batch, batch_buf, SAMPLE_BATCH_MAX_SAMPLES);
+    while (1) {
+        bool more = log_store_gets(r, line, sizeof(line)) != NULL;
+        float distance;
+        long long timestamp;
+        if (more && sscanf(line, "%f,%lld", &distance, &timestamp) != 2) {
+            continue;
+        }
+        if (more) {
+            item.distance = distance;
+            item.t_us = timestamp * 1000;
+            if (sample_batch_add(&batch, &item)) {
+                item.seq++;
+                continue;
+            }
+        }
+        size_t len = sample_batch_finish(&batch, 0, batch_seq++);
+        if (len) {
+            httpd_resp_send_chunk(req, (const char *)prefix, pb_put_varint(prefix, len) - prefix);
+            httpd_resp_send_chunk(req, (const char *)batch_buf, len);
+        }
+        sample_batch_reset(&batch);
+        if (!more) {
+            break;
+        }
+        sample_batch_add(&batch, &item);
+        item.seq++;
+    }
+    httpd_resp_send_chunk(req, NULL, 0);
+}
 
 static esp_err_t sensor_history_handler(httpd_req_t *req)
 {
@@ -57,75 +130,82 @@ static esp_err_t sensor_history_handler(httpd_req_t *req)
         }
     }
 
-    char path[64];
-    snprintf(path, sizeof(path), "%s/sensor.csv", MOUNT_POINT);
-    FILE *f = fopen(path, "r");
-    if (!f) {
+    // httpd chạy mọi handler trong một task nên buffer tĩnh là an toàn;
+    // không cấp phát heap trên đường xử lý request.
+    static log_store_reader_t r;
+    static char block[512];
+    static char out[1024];
+
+    // Snapshot: phần đã commit trên thẻ + các dòng còn trong RAM của sdcard_task, không chặn writer
+    if (log_store_open(LOG_STORE_SENSOR, &r) != ESP_OK) {
         httpd_resp_send_404(req);
         return ESP_FAIL;
     }
 
-    // Use a rolling buffer of the last N entries to avoid sending huge payloads
-    typedef struct {
-        float distance;
-        long long timestamp;
-        bool valid;
-    } history_item_t;
-
-    // Cap memory: max 1024 entries to avoid large allocs
-    int cap = limit;
-    if (cap > 1024) cap = 1024;
-    history_item_t *items = (history_item_t *)calloc(cap, sizeof(history_item_t));
-    if (!items) {
-        fclose(f);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OOM");
-        return ESP_FAIL;
+    // Tìm vị trí bắt đầu của `limit` dòng cuối bằng cách đọc ngược từ cuối snapshot
+    long end = log_store_size(&r);
+    long start = 0;
+    long pos = end;
+    int lines = 0;
+    bool skip_trailing = true;   // Newline kết thúc dòng cuối không mở dòng mới
+    while (pos > 0 && start == 0) {
+        long n = MIN(pos, (long)sizeof(block));
+        pos -= n;
+        log_store_seek(&r, pos);
+        if (log_store_read(&r, block, n) != (size_t)n) {
+            break;
+        }
+        for (long i = n - 1; i >= 0; i--) {
+            if (block[i] != '\n') {
+                skip_trailing = false;
+                continue;
+            }
+            if (skip_trailing) {
+                skip_trailing = false;
+                continue;
+            }
+            if (++lines == limit) {
+                start = pos + i + 1;
+                break;
+            }
+        }
     }
+    log_store_seek(&r, start);
 
-    int count = 0;
-    int start_index = 0; // for circular buffer
-    char line[128];
-    while (fgets(line, sizeof(line), f)) {
-        float distance;
-        long long timestamp;
-        if (sscanf(line, "%f,%lld", &distance, &timestamp) == 2) {
-            items[start_index].distance = distance;
-            items[start_index].timestamp = timestamp;
-            items[start_index].valid = true;
-            start_index = (start_index + 1) % cap;
-            if (count < cap) count++;
-        }
+    if (want_protobuf(req)) {
+        send_history_pb(req, &r);
+        log_store_close(&r);
+        return ESP_OK;
     }
-    fclose(f);
 
     httpd_resp_set_type(req, "application/json");
     httpd_resp_set_hdr(req, "Cache-Control", "no-store");
-    // Stream JSON array
-    httpd_resp_sendstr_chunk(req, "[");
 
-    char item_buf[96];
+    // Stream JSON array, gom nhiều phần tử vào một chunk
+    size_t used = 0;
+    out[used++] = '[';
     bool first = true;
-    int emitted = 0;
-    int to_emit = count;
-    for (int i = 0; i < to_emit; i++) {
-        int idx = (start_index - count + i);
-        while (idx < 0) idx += cap;
-        idx = idx % cap;
-        if (!items[idx].valid) continue;
-        if (!first) {
-            httpd_resp_sendstr_chunk(req, ",");
-        }
-        snprintf(item_buf, sizeof(item_buf),
-                 "{\"distance\":%.2f,\"timestamp\":%lld}",
-                 items[idx].distance, items[idx].timestamp);
-        httpd_resp_sendstr_chunk(req, item_buf);
+    char line[128];
+    while (log_store_gets(&r, line, sizeof(line))) {
+        float distance;
+        long long timestamp;
+        if (sscanf(line, "%f,%lld", &distance, &timestamp) != 2) {
+            continue;
+        }
+        if (sizeof(out) - used < 64) {
+            httpd_resp_send_chunk(req, out, used);
+            used = 0;
+        }
+        used += snprintf(out + used, sizeof(out) - used,
+                         "%s{\"distance\":%.2f,\"timestamp\":%lld}",
+                         first ? "" : ",", distance, timestamp);
         first = false;
-        emitted++;
     }
+    log_store_close(&r);
 
-    httpd_resp_sendstr_chunk(req, "]");
+    out[used++] = ']';
+    httpd_resp_send_chunk(req, out, used);
     httpd_resp_sendstr_chunk(req, NULL);
-    free(items);
     return ESP_OK;
 }
 
@@ -136,6 +216,191 @@ static const httpd_uri_t sensor_history = {
     .handler   = sensor_history_handler,
     .user_ctx  = NULL
 };
+
+// Send all of @p data, whatever httpd_send() takes per call
+static bool send_all(httpd_req_t *req, const char *data, size_t len)
+{
+    while (len) {
+        int n = httpd_send(req, data, len);
+        if (n <= 0) {
+            return false;   // HTTPD_SOCK_ERR_*
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Single "bytes=" range against a body of @p size bytes: 1 = use [first, last], 0 = ignore it
+// (send everything, as RFC 9110 allows for units or forms we do not serve), -1 = not satisfiable
+static int parse_range(const char *hdr, long size, long *first, long *last)
+{
+    if (strncmp(hdr, "bytes=", 6) != 0 || strchr(hdr, ',')) {
+        return 0;
+    }
+    const char *p = hdr + 6;
+    char *end;
+    if (*p == '-') {
+        // Suffix range: the last n bytes
+        long n = strtol(p + 1, &end, 10);
+        if (end == p + 1 || *end != '\0') {
+            return 0;
+        }
+        if (n <= 0 || size == 0) {
+            return -1;
+        }
+        *first = n < size ? size - n : 0;
+        *last = size - 1;
+        return 1;
+    }
+    long a = strtol(p, &end, 10);
+    if (end == p || *end != '-' || a < 0) {
+        return 0;
+    }
+    p = end + 1;
+    long b = size - 1;
+    if (*p) {
+        b = strtol(p, &end, 10);
+        if (end == p || *end != '\0' || b < a) {
+            return 0;
+        }
+    }
+    if (a >= size) {
+        return -1;
+    }
+    *first = a;
+    *last = MIN(b, size - 1);
+    return 1;
+}
+
+/* Bulk log export. /export lists the files and their segment counts;
+ * /export?file=sensor.csv&seg=N sends segment N raw, with Content-Length, ETag and Range support */
+static esp_err_t export_handler(httpd_req_t *req)
+{
+    // Static like /sensor/history: reader snapshot (~1 KB) and the send buffer
+    static log_store_reader_t r;
+    static char buf[2048];
+    log_store_file_t file = LOG_STORE_FILES;
+    long seg = -1;
+    char query[EXAMPLE_HTTP_QUERY_KEY_MAX_LEN] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char val[16];
+        if (httpd_query_key_value(query, "file", val, sizeof(val)) == ESP_OK &&
+            (file = log_store_file_from_name(val)) == LOG_STORE_FILES) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "file: sensor.csv or events.csv");
+            return ESP_FAIL;
+        }
+        if (httpd_query_key_value(query, "seg", val, sizeof(val)) == ESP_OK) {
+            // Digits only: a segment read by mistake would be appended to the client's copy
+            char *end;
+            errno = 0;
+            seg = strtol(val, &end, 10);
+            if (val[0] < '0' || val[0] > '9' || *end != '\0' || errno == ERANGE) {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "seg: segment number");
+                return ESP_FAIL;
+            }
+        }
+    }
+
+    if (file == LOG_STORE_FILES || seg < 0) {
+        int n = snprintf(buf, sizeof(buf), "{\"segment_bytes\":%ld,\"files\":[", LOG_STORE_SEGMENT_BYTES);
+        for (int i = 0; i < LOG_STORE_FILES; i++) {
+            long size = 0;
+            if (log_store_open((log_store_file_t)i, &r) == ESP_OK) {
+                size = log_store_size(&r);
+                log_store_close(&r);
+            }
+            n += snprintf(buf + n, sizeof(buf) - n, "%s{\"name\":\"%s\",\"size\":%ld,\"segments\":%ld}",
+                          i ? "," : "", log_store_file_name((log_store_file_t)i), size,
+                          (size + LOG_STORE_SEGMENT_BYTES - 1) / LOG_STORE_SEGMENT_BYTES);
+        }
+        n += snprintf(buf + n, sizeof(buf) - n, "]}");
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+        httpd_resp_send(req, buf, n);
+        return ESP_OK;
+    }
+
+    if (log_store_open(file, &r) != ESP_OK) {
+        httpd_resp_send_404(req);
+        return ESP_FAIL;
+    }
+    long size = log_store_size(&r);
+    // Range check first: seg * LOG_STORE_SEGMENT_BYTES only fits in a long for existing segments
+    if (seg >= (size + LOG_STORE_SEGMENT_BYTES - 1) / LOG_STORE_SEGMENT_BYTES) {
+        log_store_close(&r);
+        httpd_resp_send_404(req);
+        return ESP_FAIL;
+    }
+    long base = seg * LOG_STORE_SEGMENT_BYTES;
+    long len = MIN(LOG_STORE_SEGMENT_BYTES, size - base);
+
+    // ETag: segment, length and a hash of its first bytes, so a segment of another card or of
+    // a recreated file does not match. Only the last segment grows; its tag changes with it
+    uint32_t hash = 2166136261u;
+    log_store_seek(&r, base);
+    size_t head = log_store_read(&r, buf, MIN(len, 32));
+    for (size_t i = 0; i < head; i++) {
+        hash = (hash ^ (uint8_t)buf[i]) * 16777619u;
+    }
+    char etag[64];
+    snprintf(etag, sizeof(etag), "\"%s-%ld-%ld-%08lx\"", log_store_file_name(file), seg, len,
+             (unsigned long)hash);
+
+    long first = 0;
+    long last = len - 1;
+    int range = 0;
+    char hdr[64];
+    if (httpd_req_get_hdr_value_str(req, "Range", hdr, sizeof(hdr)) == ESP_OK) {
+        // If-Range: resume only if the client's partial copy is of this same segment
+        char cond[64];
+        if (httpd_req_get_hdr_value_str(req, "If-Range", cond, sizeof(cond)) != ESP_OK ||
+            strcmp(cond, etag) == 0) {
+            range = parse_range(hdr, len, &first, &last);
+        }
+    }
+
+    // Headers by hand: httpd_resp_send_chunk() switches to chunked encoding, which has no
+    // Content-Length, and httpd_resp_send() needs the whole body in RAM
+    int n;
+    if (range < 0) {
+        log_store_close(&r);
+        n = snprintf(buf, sizeof(buf), "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */%ld\r\n"
+                     "ETag: %s\r\nContent-Length: 0\r\n\r\n", len, etag);
+        return send_all(req, buf, n) ? ESP_OK : ESP_FAIL;
+    }
+    n = snprintf(buf, sizeof(buf), "HTTP/1.1 %s\r\nContent-Type: text/csv\r\nContent-Length: %ld\r\n"
+                 "Accept-Ranges: bytes\r\nETag: %s\r\nCache-Control: no-cache\r\n",
+                 range ? "206 Partial Content" : "200 OK", last - first + 1, etag);
+    if (range) {
+        n += snprintf(buf + n, sizeof(buf) - n, "Content-Range: bytes %ld-%ld/%ld\r\n", first, last, len);
+    }
+    n += snprintf(buf + n, sizeof(buf) - n, "\r\n");
+    bool ok = send_all(req, buf, n);
+
+    log_store_seek(&r, base + first);
+    long left = last - first + 1;
+    while (ok && left > 0) {
+        size_t got = log_store_read(&r, buf, MIN(left, (long)sizeof(buf)));
+        if (got == 0) {
+            break;
+        }
+        ok = send_all(req, buf, got);
+        left -= (long)got;
+    }
+    log_store_close(&r);
+    DLOGD(DLOG_MOD_HTTP, "GET /export seg %ld: %ld bytes from %ld", DLOG_I(seg), DLOG_I(last - first + 1),
+          DLOG_I(first));
+    // Body shorter than Content-Length (card read error): closing the socket tells the client to resume
+    return ok && left == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static const httpd_uri_t export_log = {
+    .uri       = "/export",
+    .method    = HTTP_GET,
+    .handler   = export_handler,
+    .user_ctx  = NULL
+};
 /* An HTTP GET handler */
 static esp_err_t hello_get_handler(httpd_req_t *req)
 {
@@ -166,6 +431,7 @@ static esp_err_t root_get_handler(httpd_req_t *req)
 {
     httpd_resp_set_type(req, "text/html");
     httpd_resp_send(req, (const char *)index_html_start, index_html_end - index_html_start);
+    boot_prof_mark(BOOT_PHASE_FIRST_HTTP);
     return ESP_OK;
 }
 
@@ -181,7 +447,7 @@ esp_err_t static_file_handler(httpd_req_t *req)
 {
     const char *filepath = NULL;
     if (strcmp(req->uri, "/styles.css") == 0) {
-        filepath = "/spiffs/styles.css"; // hoặc "/main/styles.css" nếu dùng VFS
+        filepath = CONFIG_HTTP_SERVER_APP_STATIC_DIR "/styles.css";
     }
     // Thêm các file khác nếu cần
 
@@ -346,7 +612,7 @@ static esp_err_t led_status_handler(httpd_req_t *req)
         snprintf(resp, sizeof(resp), "{\"status\":\"success\",\"led\":\"off\"}");
     }
     
-    ESP_LOGI(TAG, "LED status response: %s", resp);
+    DLOGD(DLOG_MOD_HTTP, "GET /led/status -> %d", DLOG_I(g_led_status));
     
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, resp, strlen(resp));
@@ -364,27 +630,47 @@ static const httpd_uri_t led_status = {
 /* Cảm biến siêu âm handler */
 static esp_err_t ultrasonic_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "Ultrasonic API called");
+    // Đọc snapshot mới nhất; không tiêu thụ distance_queue (dành cho sdcard_task)
+    uint32_t seq = g_distance_seq;
     float distance = g_distance;
-    // Không tiêu thụ queue để tránh mất dữ liệu lịch sử
-    float peek_value = 0.0f;
-    if (xQueueReceive(distance_queue, &peek_value, 0) == pdTRUE) {
-        distance = peek_value;
+    // Velocity / time-to-threshold từ approach_tracker (led_task cập nhật mỗi mẫu)
+    approach_state_t motion;
+    approach_tracker_get(&motion);
+
+    if (want_protobuf(req)) {
+        sample_ring_item_t item = {
+            .seq = seq,
+            .t_us = esp_timer_get_time(),
+            .distance = distance,
+            .valid = g_distance_valid,
+        };
+        sample_pb_motion_t pb_motion = {
+            .velocity_mm_s = (int32_t)(motion.velocity_cm_s * 10.0f),
+            .ttc_ms = motion.ttc_ms,
+            .alert = motion.alert,
+        };
+        uint8_t pb[SAMPLE_PB_SAMPLE_MAX_BYTES];
+        httpd_resp_set_type(req, PROTOBUF_CONTENT_TYPE);
+        httpd_resp_send(req, (const char *)pb, sample_pb_encode_sample(&item, &pb_motion, pb, sizeof(pb)));
+        sample_trace_mark(seq, SAMPLE_STAGE_HTTP_EMIT);
+        boot_prof_mark(BOOT_PHASE_FIRST_HTTP);
+        return ESP_OK;
     }
-    // Đọc khoảng cách từ cảm biến siêu âm
-    // float distance = read_ultrasonic_distance();
-    
-    ESP_LOGI(TAG, "Distance read: %.2f cm", distance);
     
-    char resp[128];
+    char resp[192];
     const char *led_str = (g_led_status == 1) ? "on" : "off";
-    snprintf(resp, sizeof(resp), "{\"distance\":%.2f,\"timestamp\":%lld,\"led\":\"%s\"}",
-             distance, esp_timer_get_time() / 1000, led_str);
+    snprintf(resp, sizeof(resp),
+             "{\"distance\":%.2f,\"timestamp\":%lld,\"led\":\"%s\",\"seq\":%lu,"
+             "\"velocity\":%.1f,\"ttc_ms\":%lu,\"alert\":%s}",
+             distance, esp_timer_get_time() / 1000, led_str, (unsigned long)seq,
+             motion.velocity_cm_s, (unsigned long)motion.ttc_ms, motion.alert ? "true" : "false");
     
-    ESP_LOGI(TAG, "Sending response: %s", resp);
+    DLOGD(DLOG_MOD_HTTP, "GET /ultrasonic -> %.2f cm, led %d", DLOG_F(distance), DLOG_I(g_led_status));
     
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, resp, strlen(resp));
+    sample_trace_mark(seq, SAMPLE_STAGE_HTTP_EMIT);
+    boot_prof_mark(BOOT_PHASE_FIRST_HTTP);
     
     return ESP_OK;
 }
@@ -396,6 +682,455 @@ static const httpd_uri_t ultrasonic = {
     .user_ctx  = NULL
 };
 
+/* Streaming distance statistics per window (1m, 1h, 24h); ?format=pb sends length-delimited Rollups */
+static esp_err_t stats_handler(httpd_req_t *req)
+{
+    sample_rollup_t r[SAMPLE_STATS_WINDOWS];
+    for (int w = 0; w < SAMPLE_STATS_WINDOWS; w++) {
+        if (sample_stats_get((sample_stats_window_t)w, &r[w]) != ESP_OK) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Statistics not started");
+            return ESP_FAIL;
+        }
+    }
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    if (want_protobuf(req)) {
+        uint8_t pb[SAMPLE_STATS_WINDOWS * (SAMPLE_PB_DELIMITER_MAX_BYTES + SAMPLE_PB_ROLLUP_MAX_BYTES)];
+        uint8_t *p = pb;
+        for (int w = 0; w < SAMPLE_STATS_WINDOWS; w++) {
+            uint8_t msg[SAMPLE_PB_ROLLUP_MAX_BYTES];
+            size_t len = sample_pb_encode_rollup(&r[w], msg, sizeof(msg));
+            p = pb_put_varint(p, len);
+            memcpy(p, msg, len);
+            p += len;
+        }
+        httpd_resp_set_type(req, PROTOBUF_CONTENT_TYPE);
+        httpd_resp_send(req, (const char *)pb, p - pb);
+        return ESP_OK;
+    }
+
+    char buf[224];
+    httpd_resp_set_type(req, "application/json");
+    for (int w = 0; w < SAMPLE_STATS_WINDOWS; w++) {
+        snprintf(buf, sizeof(buf),
+                 "%s\"%s\":{\"window_s\":%lu,\"count\":%lu,\"valid\":%lu,\"min\":%.1f,\"max\":%.1f,"
+                 "\"mean\":%.2f,\"stddev\":%.2f,\"p50\":%.1f,\"p95\":%.1f,\"p99\":%.1f}",
+                 w ? "," : "{", sample_stats_window_name((sample_stats_window_t)w),
+                 (unsigned long)r[w].window_s, (unsigned long)r[w].count, (unsigned long)r[w].valid,
+                 r[w].min_cm, r[w].max_cm, r[w].mean_cm, r[w].stddev_cm, r[w].p50_cm, r[w].p95_cm, r[w].p99_cm);
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+    httpd_resp_sendstr_chunk(req, "}");
+    httpd_resp_sendstr_chunk(req, NULL);
+    return ESP_OK;
+}
+
+static const httpd_uri_t stats = {
+    .uri       = "/stats",
+    .method    = HTTP_GET,
+    .handler   = stats_handler,
+    .user_ctx  = NULL
+};
+
+/* Distance histogram: /hist?window=hour|prev_hour|day|prev_day (default day); ?format=pb sends a Histogram */
+static esp_err_t hist_handler(httpd_req_t *req)
+{
+    // Static, like /trace: 1.6 KB of bins plus the encoded copy would not fit the httpd stack
+    static distance_hist_t h;
+    static uint8_t pb[SAMPLE_PB_HISTOGRAM_MAX_BYTES(DISTANCE_HIST_BINS)];
+    distance_hist_window_t window = DISTANCE_HIST_DAY;
+    char query[EXAMPLE_HTTP_QUERY_KEY_MAX_LEN] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char val[12];
+        if (httpd_query_key_value(query, "window", val, sizeof(val)) == ESP_OK) {
+            window = distance_hist_window_from_name(val);
+            if (window == DISTANCE_HIST_WINDOWS) {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "window: hour, prev_hour, day or prev_day");
+                return ESP_FAIL;
+            }
+        }
+    }
+    if (distance_hist_get(window, &h) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Histogram not started");
+        return ESP_FAIL;
+    }
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    if (want_protobuf(req)) {
+        sample_pb_histogram_t hdr = {
+            .window_s = h.window_s,
+            .start_ms = h.start_ms,
+            .bin_mm = CONFIG_DISTANCE_HIST_BIN_CM * 10,
+            .samples = h.samples,
+            .invalid = h.invalid,
+        };
+        size_t len = sample_pb_encode_histogram(&hdr, h.bins, DISTANCE_HIST_BINS, pb, sizeof(pb));
+        httpd_resp_set_type(req, PROTOBUF_CONTENT_TYPE);
+        httpd_resp_send(req, (const char *)pb, len);
+        return ESP_OK;
+    }
+
+    // Bins are batched into ~200-byte chunks: one chunk per bin would cost a send() each
+    char buf[224];
+    int n = snprintf(buf, sizeof(buf),
+                     "{\"window\":\"%s\",\"window_s\":%lu,\"start_s\":%lld,\"bin_cm\":%d,"
+                     "\"samples\":%lu,\"invalid\":%lu,\"bins\":[",
+                     distance_hist_window_name(window), (unsigned long)h.window_s, (long long)(h.start_ms / 1000),
+                     CONFIG_DISTANCE_HIST_BIN_CM, (unsigned long)h.samples, (unsigned long)h.invalid);
+    httpd_resp_set_type(req, "application/json");
+    for (int i = 0; i < DISTANCE_HIST_BINS; i++) {
+        if (n > (int)sizeof(buf) - 16) {
+            httpd_resp_send_chunk(req, buf, n);
+            n = 0;
+        }
+        n += snprintf(buf + n, sizeof(buf) - n, "%s%lu", i ? "," : "", (unsigned long)h.bins[i]);
+    }
+    httpd_resp_send_chunk(req, buf, n);
+    httpd_resp_sendstr_chunk(req, "]}");
+    httpd_resp_sendstr_chunk(req, NULL);
+    return ESP_OK;
+}
+
+static const httpd_uri_t hist = {
+    .uri       = "/hist",
+    .method    = HTTP_GET,
+    .handler   = hist_handler,
+    .user_ctx  = NULL
+};
+
+/* Occupancy event log: /events?since=<seq> returns events from seq on; "next" resumes the stream */
+static esp_err_t events_handler(httpd_req_t *req)
+{
+    occupancy_cursor_t cursor;
+    occupancy_cursor_init(&cursor, CONFIG_OCCUPANCY_LOG_EVENTS);
+    char query[EXAMPLE_HTTP_QUERY_KEY_MAX_LEN] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char val[12];
+        if (httpd_query_key_value(query, "since", val, sizeof(val)) == ESP_OK) {
+            cursor.next = strtoul(val, NULL, 10);
+        }
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    char buf[128];
+    occupancy_event_t ev;
+    int n = 0;
+    httpd_resp_sendstr_chunk(req, "{\"events\":[");
+    while (occupancy_read(&cursor, &ev)) {
+        snprintf(buf, sizeof(buf), "%s{\"seq\":%lu,\"type\":\"%s\",\"t_ms\":%lu,\"dwell_ms\":%lu,\"distance_mm\":%u}",
+                 n++ ? "," : "", (unsigned long)ev.seq, occupancy_event_name(ev.type), (unsigned long)ev.t_ms,
+                 (unsigned long)ev.dwell_ms, ev.distance_mm);
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+    occupancy_stats_t st;
+    occupancy_get_stats(&st);
+    snprintf(buf, sizeof(buf),
+             "],\"next\":%lu,\"dropped\":%lu,\"present\":%s,\"approaches\":%lu,\"leaves\":%lu,\"rejected\":%lu}",
+             (unsigned long)cursor.next, (unsigned long)cursor.dropped, st.present ? "true" : "false",
+             (unsigned long)st.approaches, (unsigned long)st.leaves, (unsigned long)st.rejected);
+    httpd_resp_sendstr_chunk(req, buf);
+    httpd_resp_sendstr_chunk(req, NULL);
+    return ESP_OK;
+}
+
+static const httpd_uri_t events = {
+    .uri       = "/events",
+    .method    = HTTP_GET,
+    .handler   = events_handler,
+    .user_ctx  = NULL
+};
+
+/* Per-stage sample latency histograms: /trace (?reset=1 clears, ?dump=1 also prints to console) */
+static esp_err_t trace_handler(httpd_req_t *req)
+{
+    // ~700 bytes: static to keep it off the httpd stack (handlers run in one task)
+    static sample_trace_stats_t stats;
+    bool reset = false;
+    char query[EXAMPLE_HTTP_QUERY_KEY_MAX_LEN] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char val[4];
+        if (httpd_query_key_value(query, "dump", val, sizeof(val)) == ESP_OK && atoi(val)) {
+            sample_trace_dump();
+        }
+        if (httpd_query_key_value(query, "reset", val, sizeof(val)) == ESP_OK && atoi(val)) {
+            reset = true;
+        }
+    }
+    sample_trace_get_stats(&stats);
+    if (reset) {
+        sample_trace_reset();
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    char buf[160];
+    snprintf(buf, sizeof(buf), "{\"samples\":%lu,\"stale_marks\":%lu,\"stages\":{",
+             (unsigned long)stats.samples, (unsigned long)stats.stale_marks);
+    httpd_resp_sendstr_chunk(req, buf);
+    for (int i = 0; i < SAMPLE_STAGE_MAX; i++) {
+        const sample_trace_hist_t *h = &stats.stage[i];
+        snprintf(buf, sizeof(buf),
+                 "%s\"%s\":{\"count\":%lu,\"mean_us\":%lu,\"p50_us\":%lu,\"p99_us\":%lu,\"max_us\":%lu,\"log2_buckets\":[",
+                 i ? "," : "", sample_trace_stage_name(i), (unsigned long)h->count,
+                 (unsigned long)(h->count ? h->sum_us / h->count : 0),
+                 (unsigned long)sample_trace_percentile(h, 50),
+                 (unsigned long)sample_trace_percentile(h, 99),
+                 (unsigned long)h->max_us);
+        httpd_resp_sendstr_chunk(req, buf);
+        int pos = 0;
+        for (int b = 0; b < SAMPLE_TRACE_BUCKETS; b++) {
+            pos += snprintf(buf + pos, sizeof(buf) - pos, "%s%lu", b ? "," : "",
+                            (unsigned long)h->buckets[b]);
+            if (pos > (int)sizeof(buf) - 16) {
+                httpd_resp_sendstr_chunk(req, buf);
+                pos = 0;
+            }
+        }
+        snprintf(buf + pos, sizeof(buf) - pos, "]}");
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+    httpd_resp_sendstr_chunk(req, "}}");
+    httpd_resp_sendstr_chunk(req, NULL);
+    return ESP_OK;
+}
+
+static const httpd_uri_t trace = {
+    .uri       = "/trace",
+    .method    = HTTP_GET,
+    .handler   = trace_handler,
+    .user_ctx  = NULL
+};
+
+#if !CONFIG_IDF_TARGET_LINUX
+/* Per-task CPU share over the sliding window, stack high-water marks and heap fragmentation */
+static esp_err_t sys_stats_handler(httpd_req_t *req)
+{
+    // Report is ~600 bytes: static to keep it off the httpd stack
+    static sys_monitor_report_t report;
+    static const char *const states[] = { "running", "ready", "blocked", "suspended", "deleted", "invalid" };
+    char buf[160];
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    if (sys_monitor_get_report(&report) != ESP_OK) {
+        // First window not complete yet: heap figures are still meaningful
+        memset(&report, 0, sizeof(report));
+        sys_monitor_get_heap(&report.heap);
+    }
+
+    snprintf(buf, sizeof(buf), "{\"uptime_ms\":%lu,\"window_ms\":%lu,\"tasks\":[",
+             (unsigned long)report.uptime_ms, (unsigned long)report.window_ms);
+    httpd_resp_sendstr_chunk(req, buf);
+    for (int i = 0; i < report.task_count; i++) {
+        const sys_monitor_task_t *t = &report.tasks[i];
+        char cpu[12];
+        if (t->cpu_permille == 0xFFFF) {
+            snprintf(cpu, sizeof(cpu), "null");
+        } else {
+            snprintf(cpu, sizeof(cpu), "%u.%u", t->cpu_permille / 10, t->cpu_permille % 10);
+        }
+        snprintf(buf, sizeof(buf),
+                 "%s{\"name\":\"%s\",\"priority\":%u,\"state\":\"%s\",\"cpu_pct\":%s,\"stack_hwm\":%lu}",
+                 i ? "," : "", t->name, t->priority, states[t->state < 6 ? t->state : 5], cpu,
+                 (unsigned long)t->stack_hwm);
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+    snprintf(buf, sizeof(buf),
+             "],\"heap\":{\"free\":%lu,\"min_free\":%lu,\"largest_block\":%lu,\"frag_pct\":%u}}",
+             (unsigned long)report.heap.free, (unsigned long)report.heap.min_free,
+             (unsigned long)report.heap.largest_block, report.heap.frag_pct);
+    httpd_resp_sendstr_chunk(req, buf);
+    httpd_resp_sendstr_chunk(req, NULL);
+    return ESP_OK;
+}
+
+static const httpd_uri_t sys_stats = {
+    .uri       = "/sys/stats",
+    .method    = HTTP_GET,
+    .handler   = sys_stats_handler,
+    .user_ctx  = NULL
+};
+
+/* WiFi connect/reconnect counters and times (ms) */
+static esp_err_t wifi_handler(httpd_req_t *req)
+{
+    wifi_metrics_t m;
+    char buf[384];
+    wifi_get_metrics(&m);
+    snprintf(buf, sizeof(buf),
+             "{\"connected\":%s,\"attempts\":%lu,\"connects\":%lu,\"disconnects\":%lu,"
+             "\"cache_connects\":%lu,\"full_scans\":%lu,\"boot_connect_ms\":%lu,\"last_connect_ms\":%lu,"
+             "\"last_outage_ms\":%lu,\"max_outage_ms\":%lu,\"last_reason\":%u,\"backoff_level\":%u}",
+             m.connected ? "true" : "false", (unsigned long)m.attempts, (unsigned long)m.connects,
+             (unsigned long)m.disconnects, (unsigned long)m.cache_connects, (unsigned long)m.full_scans,
+             (unsigned long)m.boot_connect_ms, (unsigned long)m.last_connect_ms,
+             (unsigned long)m.last_outage_ms, (unsigned long)m.max_outage_ms, m.last_reason, m.backoff_level);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_sendstr(req, buf);
+    return ESP_OK;
+}
+
+static const httpd_uri_t wifi_stats = {
+    .uri       = "/wifi",
+    .method    = HTTP_GET,
+    .handler   = wifi_handler,
+    .user_ctx  = NULL
+};
+
+/* SD card outages and remounts (ms), and what the flash fallback held meanwhile */
+static esp_err_t sd_handler(httpd_req_t *req)
+{
+    sdcard_metrics_t m;
+    flash_log_stats_t f;
+    char buf[512];
+    sdcard_get_metrics(&m);
+    flash_log_get_stats(&f);
+    snprintf(buf, sizeof(buf),
+             "{\"mounted\":%s,\"outages\":%lu,\"remounts\":%lu,\"mount_failures\":%lu,\"io_errors\":%lu,"
+             "\"outage_ms\":%lu,\"last_outage_ms\":%lu,\"max_outage_ms\":%lu,\"retry_in_ms\":%lu,"
+             "\"backoff_level\":%u,\"flash\":{\"segments\":%lu,\"max_segments\":%lu,\"appended\":%lu,"
+             "\"migrated\":%lu,\"overwritten\":%lu,\"writes\":%lu}}",
+             m.mounted ? "true" : "false", (unsigned long)m.outages, (unsigned long)m.remounts,
+             (unsigned long)m.mount_failures, (unsigned long)m.io_errors, (unsigned long)m.outage_ms,
+             (unsigned long)m.last_outage_ms, (unsigned long)m.max_outage_ms, (unsigned long)m.retry_in_ms,
+             m.backoff_level, (unsigned long)f.segments, (unsigned long)f.max_segments,
+             (unsigned long)f.appended, (unsigned long)f.migrated, (unsigned long)f.overwritten,
+             (unsigned long)f.writes);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_sendstr(req, buf);
+    return ESP_OK;
+}
+
+static const httpd_uri_t sd_stats = {
+    .uri       = "/sd",
+    .method    = HTTP_GET,
+    .handler   = sd_handler,
+    .user_ctx  = NULL
+};
+#endif
+
+/* Boot-phase timestamps in ms since app start; null for phases not reached yet */
+static esp_err_t boot_handler(httpd_req_t *req)
+{
+    char buf[48];
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_sendstr_chunk(req, "{");
+    for (int i = 0; i < BOOT_PHASE_MAX; i++) {
+        uint32_t us = boot_prof_get_us((boot_phase_t)i);
+        if (us) {
+            snprintf(buf, sizeof(buf), "%s\"%s\":%lu.%03lu", i ? "," : "", boot_prof_name((boot_phase_t)i),
+                     (unsigned long)(us / 1000), (unsigned long)(us % 1000));
+        } else {
+            snprintf(buf, sizeof(buf), "%s\"%s\":null", i ? "," : "", boot_prof_name((boot_phase_t)i));
+        }
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+    httpd_resp_sendstr_chunk(req, "}");
+    httpd_resp_sendstr_chunk(req, NULL);
+    return ESP_OK;
+}
+
+static const httpd_uri_t boot = {
+    .uri       = "/boot",
+    .method    = HTTP_GET,
+    .handler   = boot_handler,
+    .user_ctx  = NULL
+};
+
+/* Deferred log viewer: formats the most recent dlog records (?n=64) */
+static esp_err_t logs_handler(httpd_req_t *req)
+{
+    static const char letters[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+    int backlog = 64;
+    char query[EXAMPLE_HTTP_QUERY_KEY_MAX_LEN] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char n_str[8];
+        if (httpd_query_key_value(query, "n", n_str, sizeof(n_str)) == ESP_OK) {
+            int val = atoi(n_str);
+            if (val > 0) {
+                backlog = val;
+            }
+        }
+    }
+
+    httpd_resp_set_type(req, "text/plain");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    dlog_cursor_t cursor;
+    dlog_record_t rec;
+    char msg[96];
+    char line[160];
+    dlog_cursor_init(&cursor, backlog);
+    while (dlog_read(&cursor, &rec)) {
+        dlog_format(&rec, msg, sizeof(msg));
+        snprintf(line, sizeof(line), "%c (%lu) %s: %s\n",
+                 letters[rec.level < sizeof(letters) ? rec.level : 0],
+                 (unsigned long)rec.timestamp_ms, dlog_module_name(rec.module), msg);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+    if (cursor.dropped) {
+        snprintf(line, sizeof(line), "... %lu records overwritten while reading\n",
+                 (unsigned long)cursor.dropped);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+    httpd_resp_sendstr_chunk(req, NULL);
+    return ESP_OK;
+}
+
+static const httpd_uri_t logs = {
+    .uri       = "/logs",
+    .method    = HTTP_GET,
+    .handler   = logs_handler,
+    .user_ctx  = NULL
+};
+
+/* Runtime verbosity: /logs/level?module=sensor&level=4 (no level = read current) */
+static esp_err_t logs_level_handler(httpd_req_t *req)
+{
+    char query[EXAMPLE_HTTP_QUERY_KEY_MAX_LEN] = {0};
+    char module_str[16] = {0};
+    char level_str[4] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "module", module_str, sizeof(module_str)) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "module required");
+        return ESP_FAIL;
+    }
+    dlog_module_t module = dlog_module_from_name(module_str);
+    if (module == DLOG_MOD_MAX) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "unknown module");
+        return ESP_FAIL;
+    }
+    if (httpd_query_key_value(query, "level", level_str, sizeof(level_str)) == ESP_OK) {
+        int level = atoi(level_str);
+        if (level < ESP_LOG_NONE || level > ESP_LOG_VERBOSE) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "level must be 0..5");
+            return ESP_FAIL;
+        }
+        dlog_set_level(module, (esp_log_level_t)level);
+    }
+
+    char resp[64];
+    snprintf(resp, sizeof(resp), "{\"module\":\"%s\",\"level\":%d}",
+             dlog_module_name(module), dlog_levels[module]);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, resp, strlen(resp));
+    return ESP_OK;
+}
+
+static const httpd_uri_t logs_level = {
+    .uri       = "/logs/level",
+    .method    = HTTP_GET,
+    .handler   = logs_level_handler,
+    .user_ctx  = NULL
+};
+
 /* This handler allows the custom error handling functionality to be
  * tested from client side. For that, when a PUT request 0 is sent to
  * URI /ctrl, the /hello and /echo URIs are unregistered and following
@@ -465,8 +1200,13 @@ static const httpd_uri_t ctrl = {
 
 void start_webserver(void)
 {
+    if (server) {
+        return;     // Already running (GOT_IP after a reconnect without a disconnect event)
+    }
     // Use the global server handle
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = CONFIG_HTTP_SERVER_APP_PORT;
+    config.max_uri_handlers = 24;
     config.lru_purge_enable = true;
 
     // Start the httpd server
@@ -483,20 +1223,59 @@ void start_webserver(void)
         httpd_register_uri_handler(server, &led_status);  // Thêm endpoint LED status
         httpd_register_uri_handler(server, &ultrasonic);  // Thêm endpoint mới
         httpd_register_uri_handler(server, &sensor_history);
+        httpd_register_uri_handler(server, &export_log);
+        httpd_register_uri_handler(server, &logs);
+        httpd_register_uri_handler(server, &logs_level);
+        httpd_register_uri_handler(server, &trace);
+        httpd_register_uri_handler(server, &stats);
+        httpd_register_uri_handler(server, &hist);
+        httpd_register_uri_handler(server, &events);
+        httpd_register_uri_handler(server, &boot);
+        register_static_files(server);
+#if !CONFIG_IDF_TARGET_LINUX
+        httpd_register_uri_handler(server, &sys_stats);
+        httpd_register_uri_handler(server, &wifi_stats);
+        httpd_register_uri_handler(server, &sd_stats);
+#endif
         httpd_register_err_handler(server, HTTPD_404_NOT_FOUND, http_404_error_handler);
-
+        boot_prof_mark(BOOT_PHASE_HTTP_STARTED);
     }else{
+        server = NULL;
         ESP_LOGI(TAG, "Error starting server!");
     }
-
-
-
 }
 
 void stop_webserver(void)
 {
     // Stop the httpd server
-    httpd_stop(server);
+    if (server) {
+        httpd_stop(server);
+        server = NULL;
+    }
 }
 
+#if !CONFIG_IDF_TARGET_LINUX
+// Event loop handlers: listen as soon as there is an address, free the sockets and
+// the httpd task while the link is down
+static void got_ip_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
+{
+    start_webserver();
+}
 
+static void disconnect_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
+{
+    if (server) {
+        ESP_LOGI(TAG, "WiFi disconnected, stopping server");
+        stop_webserver();
+    }
+}
+
+esp_err_t http_server_app_start_on_ip(void)
+{
+    esp_err_t ret = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, got_ip_handler, NULL);
+    if (ret == ESP_OK) {
+        ret = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, disconnect_handler, NULL);
+    }
+    return ret;
+}
+#endif
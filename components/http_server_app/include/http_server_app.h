@@ -1,7 +1,19 @@
 #ifndef __HTTP_SERVER_APP_H
 #define __HTTP_SERVER_APP_H
 
+#include "esp_err.h"
+
 // ... (your header file contents go here)
 void start_webserver(void);
 void stop_webserver(void);
+
+/**
+ * @brief Start the server on every IP_EVENT_STA_GOT_IP and stop it on WIFI_EVENT_STA_DISCONNECTED
+ *
+ * Register before the station is started (the default event loop must exist), so
+ * the first address is not missed. Device targets only.
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t http_server_app_start_on_ip(void);
 #endif // __HTTP_SERVER_APP_H
@@ -0,0 +1,218 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Owner of the append-only log files on the SD card.
+ *
+ * One writer task (sdcard_task) appends rows into a RAM tail and commits them
+ * with one write + fsync. The file is only ever read up to the committed
+ * length; readers (HTTP handlers) open a snapshot made of that length plus a
+ * copy of the uncommitted rows, so they see every row appended so far without
+ * waiting for, or racing with, the writer. The writer only blocks for the copy.
+ *
+ * Opening, creating and resizing files on the FAT volume go through
+ * log_store_fat_lock(). Other SD users take log_store_card_lock() instead, which
+ * also tells them whether the card is mounted; the SD driver unmounts only after
+ * log_store_set_online(false), which waits for that lock.
+ *
+ * Open readers are tracked: going offline closes their files, and the rest of a
+ * snapshot that was on the card reads as a short read instead of touching a volume
+ * that is gone.
+ *
+ * While the card is missing or failing, commits go to a fallback backend (the
+ * flash_log circular log) and are moved back to the card, oldest first, once it
+ * works again. Rows parked in the fallback are not visible to readers.
+ */
+
+typedef enum {
+    LOG_STORE_SENSOR,       // sensor.csv: distance,timestamp
+    LOG_STORE_EVENTS,       // events.csv: seq,type,t_ms,dwell_ms,distance_mm
+    LOG_STORE_FILES
+} log_store_file_t;
+
+// Export granularity: segment n covers bytes [n, n + 1) * LOG_STORE_SEGMENT_BYTES
+#define LOG_STORE_SEGMENT_BYTES ((long)CONFIG_LOG_STORE_SEGMENT_KB * 1024)
+
+// Static RAM taken by the tails
+#define LOG_STORE_RAM_BYTES (LOG_STORE_FILES * CONFIG_LOG_STORE_TAIL_BYTES)
+
+// Storage backend. The card is built in; a fallback embeds this struct as its first member
+typedef struct log_backend_t log_backend_t;
+struct log_backend_t {
+    const char *name;
+    // Store rows after those already stored: the card writes and syncs them, a fallback may
+    // batch them in RAM first (flash_log: bounded by CONFIG_FLASH_LOG_BATCH_MAX_S)
+    esp_err_t (*append)(log_backend_t *be, log_store_file_t file, const char *data, size_t len);
+    // Fallback only: append the oldest stored batch to @p to, then forget it
+    esp_err_t (*drain)(log_backend_t *be, log_backend_t *to);
+    // Fallback only: rows left to drain
+    bool (*pending)(log_backend_t *be);
+};
+
+// Consistent view of one file; large, keep it static
+typedef struct log_store_reader_t log_store_reader_t;
+struct log_store_reader_t {
+    FILE *f;                // NULL once the card is gone
+    log_store_reader_t *next;   // Open readers with a file, for log_store_set_online(false)
+    long committed;         // Bytes read from the file
+    long pos;               // Read position in the snapshot
+    long file_pos;          // Position of f, -1 if unknown
+    size_t tail_len;
+    char tail[CONFIG_LOG_STORE_TAIL_BYTES];    // Rows after committed
+};
+
+/**
+ * @brief Set the directory of the log files; call once before any other function
+ *
+ * Files are opened on first use, so the card may be mounted later.
+ *
+ * @param dir Directory, e.g. "/sdcard"
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t log_store_init(const char *dir);
+
+/**
+ * @brief Append one or more whole rows (writer task only)
+ *
+ * Visible to readers immediately. A full tail is committed first, which blocks
+ * on the card.
+ *
+ * @param file Log file
+ * @param data Rows, ending with '\n'
+ * @param len Length, at most CONFIG_LOG_STORE_TAIL_BYTES
+ * @return esp_err_t ESP_OK, or the commit error when the rows were dropped
+ */
+esp_err_t log_store_append(log_store_file_t file, const char *data, size_t len);
+
+/**
+ * @brief Write the tail of a file to the card if it is due (writer task only)
+ *
+ * Rows go to the fallback instead while the card is offline, within
+ * CONFIG_LOG_STORE_RETRY_S of a failed write, or while older rows are still parked
+ * there. Each call also moves one batch of parked rows back when the card works.
+ *
+ * @param file Log file
+ * @param force Commit even if the oldest row is younger than CONFIG_LOG_STORE_COMMIT_MS
+ * @return esp_err_t ESP_OK when every row is stored (card or fallback), ESP_ERR_NOT_FINISHED
+ *         when rows wait for their commit time, ESP_FAIL when no backend took them (rows kept)
+ */
+esp_err_t log_store_commit(log_store_file_t file, bool force);
+
+/**
+ * @brief Set the backend that takes rows while the card cannot (writer task, before the first commit)
+ *
+ * @param fallback Backend, e.g. from flash_log_init(); NULL keeps rows in RAM only
+ */
+void log_store_set_fallback(log_backend_t *fallback);
+
+/**
+ * @brief Tell whether the card is mounted (writer task)
+ *
+ * Assumed online until told otherwise. While offline no card access is tried; going
+ * offline closes the files, including those of open readers, and waits for holders of
+ * log_store_card_lock() (call it before unmounting). Going online clears the pause
+ * after a failed write.
+ */
+void log_store_set_online(bool online);
+
+/**
+ * @brief Tell whether rows wait in the fallback (writer task)
+ *
+ * After a commit that returned ESP_OK, false means its rows went to the card.
+ */
+bool log_store_parked(void);
+
+/**
+ * @brief Failed card writes in a row, 0 after a good one (writer task)
+ *
+ * For the SD driver to tell a glitch from a card that is gone.
+ */
+uint32_t log_store_card_errors(void);
+
+/**
+ * @brief Open a snapshot of a file for reading (any task)
+ *
+ * @param file Log file
+ * @param r Reader
+ * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND if the file has no rows yet,
+ *         ESP_ERR_INVALID_STATE before log_store_init()
+ */
+esp_err_t log_store_open(log_store_file_t file, log_store_reader_t *r);
+
+/**
+ * @brief Snapshot size in bytes (committed length plus RAM tail)
+ */
+long log_store_size(const log_store_reader_t *r);
+
+/**
+ * @brief Move the read position (clamped to the snapshot)
+ *
+ * @param r Reader
+ * @param offset Byte offset from the start
+ */
+void log_store_seek(log_store_reader_t *r, long offset);
+
+/**
+ * @brief Read bytes from the current position
+ *
+ * @return size_t Bytes read, 0 at the end of the snapshot
+ */
+size_t log_store_read(log_store_reader_t *r, void *buf, size_t len);
+
+/**
+ * @brief Read one line, like fgets()
+ *
+ * @return char* @p line, or NULL at the end of the snapshot
+ */
+char *log_store_gets(log_store_reader_t *r, char *line, size_t len);
+
+/**
+ * @brief Release a reader
+ */
+void log_store_close(log_store_reader_t *r);
+
+/**
+ * @brief File name as stored and as used by GET /export ("sensor.csv", "events.csv")
+ */
+const char *log_store_file_name(log_store_file_t file);
+
+/**
+ * @brief Look up a file by name
+ *
+ * @return log_store_file_t File, or LOG_STORE_FILES if not found
+ */
+log_store_file_t log_store_file_from_name(const char *name);
+
+/**
+ * @brief Serialise FAT metadata operations (open, create, truncate, rename, unlink)
+ */
+void log_store_fat_lock(void);
+void log_store_fat_unlock(void);
+
+/**
+ * @brief Take the FAT lock if the card is mounted (any task)
+ *
+ * For SD users outside log_store: every file they open while holding it must be
+ * closed before log_store_fat_unlock(), so no handle outlives an unmount.
+ *
+ * @return true with the lock held, false (lock not held) while the card is offline
+ */
+bool log_store_card_lock(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,453 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "log_store.h"
+#include <string.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dlog.h"
+
+static const char *TAG = "log_store";
+
+#define TAIL_BYTES  CONFIG_LOG_STORE_TAIL_BYTES
+#define COMMIT_US   ((int64_t)CONFIG_LOG_STORE_COMMIT_MS * 1000)
+
+typedef struct {
+    const char *name;
+    char path[48];
+    FILE *f;                // Writer handle, unbuffered: the tail is the buffer
+    bool sized;             // committed is known (opened once on the current card)
+    long committed;         // Bytes written and fsync'ed
+    size_t len;             // Tail bytes
+    int64_t first_us;       // Append time of the oldest tail row
+    char tail[TAIL_BYTES];
+} store_t;
+
+static store_t s_files[LOG_STORE_FILES] = {
+    [LOG_STORE_SENSOR] = { .name = "sensor.csv" },
+    [LOG_STORE_EVENTS] = { .name = "events.csv" },
+};
+
+// s_lock guards committed/len/tail (held for a memcpy at most); s_fat_lock guards FAT metadata,
+// the reader list and reader file access
+static SemaphoreHandle_t s_lock;
+static StaticSemaphore_t s_lock_buf;
+static SemaphoreHandle_t s_fat_lock;
+static StaticSemaphore_t s_fat_lock_buf;
+
+esp_err_t log_store_init(const char *dir)
+{
+    s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+    s_fat_lock = xSemaphoreCreateMutexStatic(&s_fat_lock_buf);
+    if (!s_lock || !s_fat_lock) {
+        return ESP_FAIL;
+    }
+    for (int i = 0; i < LOG_STORE_FILES; i++) {
+        int n = snprintf(s_files[i].path, sizeof(s_files[i].path), "%s/%s", dir, s_files[i].name);
+        if (n >= (int)sizeof(s_files[i].path)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    return ESP_OK;
+}
+
+void log_store_fat_lock(void)
+{
+    xSemaphoreTake(s_fat_lock, portMAX_DELAY);
+}
+
+void log_store_fat_unlock(void)
+{
+    xSemaphoreGive(s_fat_lock);
+}
+
+// Card state seen by the writer: mounted (log_store_set_online) and not pausing after a failed write.
+// s_online changes under s_fat_lock so log_store_card_lock() can rely on it
+static bool s_online = true;
+static int64_t s_retry_us;
+static uint32_t s_errors;      // Failed card writes in a row
+static log_backend_t *s_fallback;
+static log_store_reader_t *s_readers;  // Readers holding a file on the card
+
+bool log_store_card_lock(void)
+{
+    if (!s_fat_lock) {
+        return false;
+    }
+    log_store_fat_lock();
+    if (!s_online) {
+        log_store_fat_unlock();
+        return false;
+    }
+    return true;
+}
+
+// Writer side: open for append; after a failed write, cut the file back to the committed length
+static bool writer_open(store_t *s)
+{
+    if (s->f) {
+        return true;
+    }
+    log_store_fat_lock();
+    s->f = fopen(s->path, "a+");
+    long size = -1;
+    if (s->f) {
+        setvbuf(s->f, NULL, _IONBF, 0);
+        if (fseek(s->f, 0, SEEK_END) == 0) {
+            size = ftell(s->f);
+        }
+        if (s->sized && size > s->committed) {
+            ESP_LOGW(TAG, "%s: dropping %ld bytes of a failed write", s->name, size - s->committed);
+            size = ftruncate(fileno(s->f), s->committed) == 0 ? s->committed : -1;
+        } else if (!s->sized && size > 0) {
+            // First open on this card (or after it was lost): a row torn by the removal must not
+            // swallow the next one. Nothing is cut, it may be another card
+            if (fseek(s->f, -1, SEEK_END) == 0 && fgetc(s->f) != '\n' &&
+                fseek(s->f, 0, SEEK_END) == 0 && fwrite("\n", 1, 1, s->f) == 1) {
+                size++;
+            }
+        }
+    }
+    if (size < 0) {
+        if (s->f) {
+            fclose(s->f);
+            s->f = NULL;
+        }
+        log_store_fat_unlock();
+        return false;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s->committed = size;
+    s->sized = true;
+    xSemaphoreGive(s_lock);
+    log_store_fat_unlock();
+    return true;
+}
+
+static bool sd_usable(void)
+{
+    return s_online && esp_timer_get_time() >= s_retry_us;
+}
+
+// Write to the card; with from_tail the tail is dropped in the same step that readers see
+static esp_err_t sd_write(store_t *s, const char *data, size_t len, bool from_tail)
+{
+    bool ok = writer_open(s) && fwrite(data, 1, len, s->f) == len && fsync(fileno(s->f)) == 0;
+    if (!ok) {
+        // Reopen next time (a torn write is truncated away then); no card access until the retry time
+        if (s->f) {
+            log_store_fat_lock();
+            fclose(s->f);
+            s->f = NULL;
+            log_store_fat_unlock();
+        }
+        s_retry_us = esp_timer_get_time() + (int64_t)CONFIG_LOG_STORE_RETRY_S * 1000000;
+        s_errors++;
+        DLOGE(DLOG_MOD_SD, "log_store: write of %u bytes failed", DLOG_U(len));
+        return ESP_FAIL;
+    }
+    s_errors = 0;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s->committed += (long)len;
+    if (from_tail) {
+        s->len = 0;
+    }
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+// The card as a backend: where a fallback drains its rows to
+static esp_err_t sd_backend_append(log_backend_t *be, log_store_file_t file, const char *data, size_t len)
+{
+    if (!sd_usable()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return sd_write(&s_files[file], data, len, false);
+}
+
+static log_backend_t s_sd_backend = {
+    .name = "sd",
+    .append = sd_backend_append,
+};
+
+void log_store_set_fallback(log_backend_t *fallback)
+{
+    s_fallback = fallback;
+}
+
+void log_store_set_online(bool online)
+{
+    if (online && !s_online) {
+        s_retry_us = 0;
+        s_errors = 0;
+    }
+    log_store_fat_lock();
+    if (!online) {
+        // The volume is about to go: drop the handles, and size the files afresh on the next card
+        for (int i = 0; i < LOG_STORE_FILES; i++) {
+            store_t *s = &s_files[i];
+            if (s->f) {
+                fclose(s->f);
+                s->f = NULL;
+            }
+            xSemaphoreTake(s_lock, portMAX_DELAY);
+            s->sized = false;
+            xSemaphoreGive(s_lock);
+        }
+        // Readers keep their snapshot; what was still to be read from the card ends short
+        int closed = 0;
+        for (log_store_reader_t *r = s_readers; r; r = r->next) {
+            fclose(r->f);
+            r->f = NULL;
+            closed++;
+        }
+        s_readers = NULL;
+        if (closed) {
+            ESP_LOGW(TAG, "Card going offline: closed %d open reader(s)", closed);
+        }
+    }
+    s_online = online;
+    log_store_fat_unlock();
+}
+
+bool log_store_parked(void)
+{
+    return s_fallback && s_fallback->pending(s_fallback);
+}
+
+uint32_t log_store_card_errors(void)
+{
+    return s_errors;
+}
+
+// Move one batch of parked rows back to the card; rows committed meanwhile keep queueing behind them
+static void migrate_step(void)
+{
+    if (!s_fallback || !s_fallback->pending(s_fallback) || !sd_usable()) {
+        return;
+    }
+    if (s_fallback->drain(s_fallback, &s_sd_backend) == ESP_OK && !s_fallback->pending(s_fallback)) {
+        ESP_LOGI(TAG, "Rows parked in %s are back on the card", s_fallback->name);
+    }
+}
+
+esp_err_t log_store_commit(log_store_file_t file, bool force)
+{
+    if ((unsigned)file >= LOG_STORE_FILES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    store_t *s = &s_files[file];
+    migrate_step();
+    // Only this task changes the tail, so it can be written without holding s_lock
+    if (s->len == 0) {
+        return ESP_OK;
+    }
+    if (!force && esp_timer_get_time() - s->first_us < COMMIT_US) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+    if (!log_store_parked() && sd_usable() && sd_write(s, s->tail, s->len, true) == ESP_OK) {
+        return ESP_OK;
+    }
+    // Card absent or failing, or older rows still parked: park these behind them. No fopen on a
+    // card that just failed; readers see parked rows again once they are moved back
+    if (!s_fallback || s_fallback->append(s_fallback, file, s->tail, s->len) != ESP_OK) {
+        return ESP_FAIL;    // Rows stay in RAM
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s->len = 0;
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+esp_err_t log_store_append(log_store_file_t file, const char *data, size_t len)
+{
+    if ((unsigned)file >= LOG_STORE_FILES || len > TAIL_BYTES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    store_t *s = &s_files[file];
+    if (s->len + len > TAIL_BYTES) {
+        esp_err_t err = log_store_commit(file, true);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s->len == 0) {
+        s->first_us = esp_timer_get_time();
+    }
+    memcpy(s->tail + s->len, data, len);
+    s->len += len;
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+esp_err_t log_store_open(log_store_file_t file, log_store_reader_t *r)
+{
+    if ((unsigned)file >= LOG_STORE_FILES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    store_t *s = &s_files[file];
+    r->pos = 0;
+    r->file_pos = -1;
+
+    // Under the FAT lock the writer cannot open the file between the copy and the size check
+    log_store_fat_lock();
+    r->f = s_online ? fopen(s->path, "r") : NULL;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool sized = s->sized;
+    r->committed = s->committed;
+    r->tail_len = s->len;
+    memcpy(r->tail, s->tail, s->len);
+    xSemaphoreGive(s_lock);
+    if (!sized) {
+        // Not opened by the writer yet: nothing is being appended, the whole file counts
+        r->committed = 0;
+        if (r->f && fseek(r->f, 0, SEEK_END) == 0) {
+            r->committed = ftell(r->f);
+        }
+    }
+    if (r->f) {
+        r->next = s_readers;
+        s_readers = r;
+    }
+    log_store_fat_unlock();
+
+    if (!r->f) {
+        r->committed = 0;
+    }
+    if (log_store_size(r) == 0) {
+        log_store_close(r);
+        return ESP_ERR_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+long log_store_size(const log_store_reader_t *r)
+{
+    return r->committed + (long)r->tail_len;
+}
+
+void log_store_seek(log_store_reader_t *r, long offset)
+{
+    r->pos = offset < 0 ? 0 : MIN(offset, log_store_size(r));
+}
+
+// Position f at r->pos; false if the file is shorter than the snapshot says or was closed
+// with the card. Called with the FAT lock held
+static bool file_sync_pos(log_store_reader_t *r)
+{
+    if (!r->f) {
+        return false;
+    }
+    if (r->file_pos != r->pos) {
+        if (fseek(r->f, r->pos, SEEK_SET) != 0) {
+            return false;
+        }
+        r->file_pos = r->pos;
+    }
+    return true;
+}
+
+size_t log_store_read(log_store_reader_t *r, void *buf, size_t len)
+{
+    uint8_t *out = buf;
+    size_t done = 0;
+    if (r->pos < r->committed && len) {
+        size_t n = MIN(len, (size_t)(r->committed - r->pos));
+        log_store_fat_lock();
+        n = file_sync_pos(r) ? fread(out, 1, n, r->f) : 0;
+        log_store_fat_unlock();
+        r->pos += (long)n;
+        r->file_pos += (long)n;
+        done = n;
+        if (r->pos < r->committed) {
+            return done;    // Short read from the card
+        }
+    }
+    if (done < len && r->pos < log_store_size(r)) {
+        size_t n = MIN(len - done, (size_t)(log_store_size(r) - r->pos));
+        memcpy(out + done, r->tail + (r->pos - r->committed), n);
+        r->pos += (long)n;
+        done += n;
+    }
+    return done;
+}
+
+char *log_store_gets(log_store_reader_t *r, char *line, size_t len)
+{
+    size_t i = 0;
+    // One lock per line: the card may go offline between two calls, not within one
+    bool locked = r->pos < r->committed;
+    if (locked) {
+        log_store_fat_lock();
+    }
+    while (i + 1 < len) {
+        int c;
+        if (r->pos < r->committed) {
+            if (!file_sync_pos(r) || (c = fgetc(r->f)) == EOF) {
+                break;
+            }
+            r->file_pos++;
+        } else if (r->pos < log_store_size(r)) {
+            c = (unsigned char)r->tail[r->pos - r->committed];
+        } else {
+            break;
+        }
+        r->pos++;
+        line[i++] = (char)c;
+        if (c == '\n') {
+            break;
+        }
+    }
+    if (locked) {
+        log_store_fat_unlock();
+    }
+    if (i == 0) {
+        return NULL;
+    }
+    line[i] = '\0';
+    return line;
+}
+
+const char *log_store_file_name(log_store_file_t file)
+{
+    if ((unsigned)file >= LOG_STORE_FILES) {
+        return "?";
+    }
+    return s_files[file].name;
+}
+
+log_store_file_t log_store_file_from_name(const char *name)
+{
+    for (int i = 0; i < LOG_STORE_FILES; i++) {
+        if (strcmp(name, s_files[i].name) == 0) {
+            return (log_store_file_t)i;
+        }
+    }
+    return LOG_STORE_FILES;
+}
+
+void log_store_close(log_store_reader_t *r)
+{
+    log_store_fat_lock();
+    if (r->f) {
+        for (log_store_reader_t **p = &s_readers; *p; p = &(*p)->next) {
+            if (*p == r) {
+                *p = r->next;
+                break;
+            }
+        }
+        fclose(r->f);
+        r->f = NULL;
+    }
+    log_store_fat_unlock();
+}
@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "sample_batch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * MQTT uplink.
+ *
+ * mqtt_pub follows the sample ring with its own cursor, packs readings into
+ * protobuf Batch messages (sample_batch) and publishes each with QoS 1, waiting
+ * for PUBACK.
+ * While the broker is unreachable (or a PUBACK times out) batches are appended to
+ * a spool file on the SD card; after a reconnect the spool is replayed oldest
+ * first at CONFIG_MQTT_TELEMETRY_REPLAY_PER_S, and new batches queue behind it
+ * so the broker always sees them in order. Delivery is at-least-once.
+ * Occupancy events go to <prefix>/<id>/events as JSON (QoS 0).
+ */
+
+// Counters since boot
+typedef struct {
+    uint32_t batches;           // Batches built
+    uint32_t samples;           // Samples packed into them
+    uint32_t published;         // Live batches acknowledged by the broker
+    uint32_t spooled;           // Batches written to the spool
+    uint32_t replayed;          // Spooled batches acknowledged by the broker
+    uint32_t dropped;           // Batches lost (spool full or unavailable)
+    uint32_t ring_dropped;      // Samples overwritten in the ring before mqtt_pub read them
+    uint32_t spool_pending;     // Bytes of the spool not replayed yet
+    uint32_t last_ack_ms;       // Publish-to-PUBACK time of the last batch
+    uint32_t events;            // Occupancy events published
+    bool connected;
+} mqtt_telemetry_stats_t;
+
+#if CONFIG_MQTT_TELEMETRY_ENABLE
+// Static RAM taken by mqtt_pub (stack, batch and replay buffers)
+#define MQTT_TELEMETRY_RAM_BYTES (CONFIG_MQTT_TELEMETRY_TASK_STACK + \
+                                  2 * SAMPLE_BATCH_BYTES(CONFIG_MQTT_TELEMETRY_BATCH_SAMPLES) + 2)
+#else
+#define MQTT_TELEMETRY_RAM_BYTES 0
+#endif
+
+/**
+ * @brief Create the MQTT client and mqtt_pub
+ *
+ * Call after wifi_init_sta(); the client connects once the station has an address
+ * and reconnects on its own. Does nothing when CONFIG_MQTT_TELEMETRY_ENABLE is off.
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t mqtt_telemetry_start(void);
+
+/**
+ * @brief Copy the uplink counters
+ */
+void mqtt_telemetry_get_stats(mqtt_telemetry_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
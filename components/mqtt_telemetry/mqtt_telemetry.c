@@ -0,0 +1,481 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "mqtt_telemetry.h"
+
+#if CONFIG_MQTT_TELEMETRY_ENABLE
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_mac.h"
+#include "esp_random.h"
+#include "mqtt_client.h"
+#include "sample_ring.h"
+#include "occupancy.h"
+#include "log_store.h"
+#include "dlog.h"
+
+static const char *TAG = "mqtt_telemetry";
+
+#define BATCH_SAMPLES   CONFIG_MQTT_TELEMETRY_BATCH_SAMPLES
+#define BATCH_BYTES     SAMPLE_BATCH_BYTES(BATCH_SAMPLES)
+#define TASK_PERIOD_MS  100
+#define STATS_LOG_US    (60 * 1000000LL)
+
+#if CONFIG_MQTT_TELEMETRY_SPOOL
+// One replay per loop at most
+_Static_assert(CONFIG_MQTT_TELEMETRY_REPLAY_PER_S * TASK_PERIOD_MS <= 1000,
+               "CONFIG_MQTT_TELEMETRY_REPLAY_PER_S above the mqtt_pub loop rate");
+#endif
+
+// Task notification value for "connection lost"; QoS 1 message IDs start at 1
+#define NOTIFY_DISCONNECTED 0
+
+static esp_mqtt_client_handle_t s_client;
+static TaskHandle_t s_task;
+static volatile bool s_connected;
+static char s_topic[64];
+static char s_status_topic[64];
+static char s_events_topic[64];
+static char s_client_id[24];
+static uint16_t s_boot_id;
+static uint32_t s_batch_seq;
+
+// Written by mqtt_pub only (connected by the MQTT event handler); 32-bit fields, no lock
+static mqtt_telemetry_stats_t s_stats;
+
+static StackType_t s_task_stack[CONFIG_MQTT_TELEMETRY_TASK_STACK];
+static StaticTask_t s_task_tcb;
+static uint8_t s_batch_buf[BATCH_BYTES];
+static sample_batch_t s_batch;
+
+#if CONFIG_MQTT_TELEMETRY_SPOOL
+/*
+ * Spool: fixed-size slots "len u16 | payload | zero padding". Fixed slots make the
+ * torn tail after a power cut a simple size % SLOT_BYTES truncation instead of a scan
+ * over the whole file. mqtt.idx stores the slot size and the replay offset.
+ * Every open, unlink and truncate on the card holds log_store_card_lock(), so nothing
+ * is open when the card is unmounted; an unmount forgets the spool until the next mount.
+ */
+#define SPOOL_FILE      CONFIG_MQTT_TELEMETRY_SPOOL_DIR "/mqtt.spl"
+#define SPOOL_INDEX     CONFIG_MQTT_TELEMETRY_SPOOL_DIR "/mqtt.idx"
+#define SPOOL_MAX_BYTES ((uint32_t)CONFIG_MQTT_TELEMETRY_SPOOL_MAX_KB * 1024)
+#define SLOT_BYTES      (2 + BATCH_BYTES)
+#define SPOOL_MAGIC     0x324C5053  // "SPL2": protobuf batches
+// Acks between index writes: after a reboot at most this many batches are sent twice
+#define INDEX_EVERY     8
+
+typedef struct {
+    uint32_t magic;
+    uint32_t slot_bytes;
+    uint32_t read_offset;
+} spool_index_t;
+
+static uint8_t s_slot_buf[SLOT_BYTES];
+static bool s_spool_ready;
+static uint32_t s_spool_read;       // Offset of the next slot to replay
+static uint32_t s_spool_size;       // File size, a multiple of SLOT_BYTES
+static uint32_t s_index_dirty;
+
+static void spool_clear(void)
+{
+    if (log_store_card_lock()) {
+        unlink(SPOOL_FILE);
+        unlink(SPOOL_INDEX);
+        log_store_fat_unlock();
+    }
+    s_spool_read = 0;
+    s_spool_size = 0;
+    s_index_dirty = 0;
+    s_stats.spool_pending = 0;
+}
+
+static void spool_write_index(void)
+{
+    spool_index_t index = {
+        .magic = SPOOL_MAGIC,
+        .slot_bytes = SLOT_BYTES,
+        .read_offset = s_spool_read,
+    };
+    if (log_store_card_lock()) {
+        FILE *f = fopen(SPOOL_INDEX, "wb");
+        if (f) {
+            fwrite(&index, sizeof(index), 1, f);
+            fclose(f);
+        }
+        log_store_fat_unlock();
+    }
+    s_index_dirty = 0;
+}
+
+// Pick up a spool left by a previous boot or card; false while the SD card is not mounted
+static bool spool_open(void)
+{
+    if (s_spool_ready) {
+        return true;
+    }
+    struct stat st;
+    if (!log_store_card_lock()) {
+        return false;
+    }
+    if (stat(CONFIG_MQTT_TELEMETRY_SPOOL_DIR, &st) != 0) {
+        log_store_fat_unlock();
+        return false;
+    }
+    s_spool_ready = true;
+    s_spool_read = 0;
+    s_spool_size = 0;
+    if (stat(SPOOL_FILE, &st) != 0) {
+        log_store_fat_unlock();
+        return true;
+    }
+
+    spool_index_t index = { 0 };
+    FILE *f = fopen(SPOOL_INDEX, "rb");
+    if (f) {
+        fread(&index, sizeof(index), 1, f);
+        fclose(f);
+    }
+    bool known = index.magic == SPOOL_MAGIC && index.slot_bytes == SLOT_BYTES;
+    uint32_t size = (uint32_t)st.st_size;
+    uint32_t whole = size - size % SLOT_BYTES;
+    if (known && whole != size) {
+        ESP_LOGW(TAG, "Spool tail torn, truncating %lu -> %lu", (unsigned long)size, (unsigned long)whole);
+        truncate(SPOOL_FILE, whole);
+    }
+    log_store_fat_unlock();
+
+    if (!known) {
+        // Written with another CONFIG_MQTT_TELEMETRY_BATCH_SAMPLES: slots cannot be parsed
+        ESP_LOGW(TAG, "Discarding spool with unknown layout (%ld bytes)", (long)st.st_size);
+        spool_clear();
+        return true;
+    }
+    if (index.read_offset >= whole || index.read_offset % SLOT_BYTES) {
+        spool_clear();
+        return true;
+    }
+    s_spool_read = index.read_offset;
+    s_spool_size = whole;
+    s_stats.spool_pending = s_spool_size - s_spool_read;
+    ESP_LOGI(TAG, "Spool holds %lu batches to replay", (unsigned long)((whole - s_spool_read) / SLOT_BYTES));
+    return true;
+}
+
+static bool spool_pending(void)
+{
+    return s_spool_ready && s_spool_read < s_spool_size;
+}
+
+static bool spool_append(const uint8_t *data, size_t len)
+{
+    if (!spool_open() || s_spool_size + SLOT_BYTES > SPOOL_MAX_BYTES) {
+        return false;
+    }
+    bool fresh = s_spool_size == 0;
+    s_slot_buf[0] = (uint8_t)len;
+    s_slot_buf[1] = (uint8_t)(len >> 8);
+    memcpy(s_slot_buf + 2, data, len);
+    memset(s_slot_buf + 2 + len, 0, SLOT_BYTES - 2 - len);
+
+    if (!log_store_card_lock()) {
+        s_spool_ready = false;  // Card gone: read the spool again from whatever card comes back
+        return false;
+    }
+    FILE *f = fopen(SPOOL_FILE, "ab");
+    // One fsync per batch (every few seconds at most): the spool survives a power cut
+    bool ok = f && fwrite(s_slot_buf, SLOT_BYTES, 1, f) == 1 && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    if (f) {
+        fclose(f);
+    }
+    log_store_fat_unlock();
+    if (!ok) {
+        return false;
+    }
+    s_spool_size += SLOT_BYTES;
+    s_stats.spool_pending = s_spool_size - s_spool_read;
+    if (fresh) {
+        spool_write_index();
+    }
+    return true;
+}
+#endif // CONFIG_MQTT_TELEMETRY_SPOOL
+
+static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    esp_mqtt_event_handle_t event = event_data;
+    switch ((esp_mqtt_event_id_t)event_id) {
+        case MQTT_EVENT_CONNECTED:
+            s_connected = true;
+            s_stats.connected = true;
+            // QoS 0: its PUBACK would otherwise race with the batch acks mqtt_pub waits for
+            esp_mqtt_client_publish(s_client, s_status_topic, "online", 0, 0, 1);
+            ESP_LOGI(TAG, "Connected to %s", CONFIG_MQTT_TELEMETRY_BROKER_URI);
+            break;
+        case MQTT_EVENT_DISCONNECTED:
+            s_connected = false;
+            s_stats.connected = false;
+            if (s_task) {
+                xTaskNotify(s_task, NOTIFY_DISCONNECTED, eSetValueWithOverwrite);
+            }
+            break;
+        case MQTT_EVENT_PUBLISHED:
+            if (s_task) {
+                xTaskNotify(s_task, (uint32_t)event->msg_id, eSetValueWithOverwrite);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Publish with QoS 1 and block until the broker acknowledges this message
+static esp_err_t publish_wait(const uint8_t *data, size_t len)
+{
+    if (!s_connected) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xTaskNotifyStateClear(NULL);
+    ulTaskNotifyValueClear(NULL, UINT32_MAX);
+
+    int64_t start = esp_timer_get_time();
+    int msg_id = esp_mqtt_client_publish(s_client, s_topic, (const char *)data, (int)len, 1, 0);
+    if (msg_id <= 0) {
+        return ESP_FAIL;
+    }
+
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(CONFIG_MQTT_TELEMETRY_ACK_TIMEOUT_MS);
+    while (1) {
+        TickType_t now = xTaskGetTickCount();
+        uint32_t value = 0;
+        if ((int32_t)(deadline - now) <= 0 || xTaskNotifyWait(0, UINT32_MAX, &value, deadline - now) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+        if (value == NOTIFY_DISCONNECTED) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (value == (uint32_t)msg_id) {
+            break;
+        }
+    }
+    s_stats.last_ack_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    return ESP_OK;
+}
+
+// Send a finished batch, or queue it behind the spool so the broker sees batches in order
+static void deliver(const uint8_t *data, size_t len)
+{
+#if CONFIG_MQTT_TELEMETRY_SPOOL
+    // A spool left by a previous boot or card counts too: older batches go out first
+    spool_open();
+    if (spool_pending()) {
+        if (spool_append(data, len)) {
+            s_stats.spooled++;
+        } else {
+            s_stats.dropped++;
+        }
+        return;
+    }
+#endif
+    if (publish_wait(data, len) == ESP_OK) {
+        s_stats.published++;
+        return;
+    }
+#if CONFIG_MQTT_TELEMETRY_SPOOL
+    if (spool_append(data, len)) {
+        s_stats.spooled++;
+        return;
+    }
+#endif
+    s_stats.dropped++;
+    DLOGW(DLOG_MOD_UPLINK, "mqtt: batch %lu dropped", DLOG_U(s_batch_seq - 1));
+}
+
+#if CONFIG_MQTT_TELEMETRY_SPOOL
+// Replay the oldest spooled batch; the offset advances only after its PUBACK
+static void spool_replay_one(void)
+{
+    if (!log_store_card_lock()) {
+        s_spool_ready = false;
+        return;
+    }
+    FILE *f = fopen(SPOOL_FILE, "rb");
+    bool ok = f && fseek(f, (long)s_spool_read, SEEK_SET) == 0 && fread(s_slot_buf, SLOT_BYTES, 1, f) == 1;
+    if (f) {
+        fclose(f);
+    }
+    log_store_fat_unlock();
+    if (!f) {
+        spool_clear();
+        return;
+    }
+    size_t len = s_slot_buf[0] | (s_slot_buf[1] << 8);
+    if (!ok || len == 0 || len > BATCH_BYTES) {
+        ESP_LOGE(TAG, "Spool unreadable at %lu, discarding it", (unsigned long)s_spool_read);
+        spool_clear();
+        return;
+    }
+
+    if (publish_wait(s_slot_buf + 2, len) != ESP_OK) {
+        return;
+    }
+    s_stats.replayed++;
+    s_spool_read += SLOT_BYTES;
+    s_stats.spool_pending = s_spool_size - s_spool_read;
+    if (s_spool_read >= s_spool_size) {
+        DLOGI(DLOG_MOD_UPLINK, "mqtt: spool drained, %lu batches replayed", DLOG_U(s_stats.replayed));
+        spool_clear();
+    } else if (++s_index_dirty >= INDEX_EVERY) {
+        spool_write_index();
+    }
+}
+#endif
+
+static void flush_batch(void)
+{
+    s_stats.batches++;
+    s_stats.samples += s_batch.count;
+    size_t len = sample_batch_finish(&s_batch, s_boot_id, s_batch_seq++);
+    deliver(s_batch_buf, len);
+    sample_batch_reset(&s_batch);
+}
+
+// Occupancy events as small JSON messages, QoS 0: the SD event log is the durable copy.
+// While offline the cursor stays put, so up to CONFIG_OCCUPANCY_LOG_EVENTS arrive after the reconnect.
+static void publish_events(occupancy_cursor_t *cursor)
+{
+    occupancy_event_t ev;
+    char msg[112];
+    while (s_connected && occupancy_read(cursor, &ev)) {
+        int len = snprintf(msg, sizeof(msg),
+                           "{\"seq\":%lu,\"type\":\"%s\",\"t_ms\":%lu,\"dwell_ms\":%lu,\"distance_mm\":%u}",
+                           (unsigned long)ev.seq, occupancy_event_name(ev.type), (unsigned long)ev.t_ms,
+                           (unsigned long)ev.dwell_ms, ev.distance_mm);
+        esp_mqtt_client_publish(s_client, s_events_topic, msg, len, 0, 0);
+        s_stats.events++;
+    }
+}
+
+static void mqtt_pub_task(void *pvParameters)
+{
+    sample_ring_cursor_t cursor;
+    sample_ring_item_t item;
+    int64_t batch_start_us = 0;
+    int64_t next_replay_us = 0;
+    int64_t next_log_us = esp_timer_get_time() + STATS_LOG_US;
+
+    occupancy_cursor_t events;
+    occupancy_cursor_init(&events, 0);
+
+    sample_ring_cursor_init(&cursor, 0);
+    sample_batch_init(&s_batch, s_batch_buf, BATCH_SAMPLES);
+    while (1) {
+        int64_t now = esp_timer_get_time();
+        publish_events(&events);
+        while (sample_ring_read(&cursor, &item)) {
+            // Full batch or a gap in the sequence numbers: close the batch and start a new one
+            if (!sample_batch_add(&s_batch, &item)) {
+                flush_batch();
+                sample_batch_add(&s_batch, &item);
+            }
+            if (s_batch.count == 1) {
+                batch_start_us = now;
+            }
+            if (s_batch.count == BATCH_SAMPLES) {
+                flush_batch();
+            }
+        }
+        s_stats.ring_dropped = cursor.dropped;
+        if (s_batch.count && now - batch_start_us >= CONFIG_MQTT_TELEMETRY_BATCH_INTERVAL_MS * 1000LL) {
+            flush_batch();
+        }
+
+#if CONFIG_MQTT_TELEMETRY_SPOOL
+        // Picks up a spool found on the card (boot, remount) so it is replayed without waiting
+        // for a failed publish
+        if (s_connected) {
+            spool_open();
+        }
+        if (s_connected && spool_pending() && now >= next_replay_us) {
+            spool_replay_one();
+            next_replay_us = esp_timer_get_time() + 1000000 / CONFIG_MQTT_TELEMETRY_REPLAY_PER_S;
+        }
+#else
+        (void)next_replay_us;
+#endif
+
+        if (now >= next_log_us) {
+            next_log_us = now + STATS_LOG_US;
+            DLOGI(DLOG_MOD_UPLINK, "mqtt: %lu published, %lu spooled, %lu replayed, %lu dropped",
+                  DLOG_U(s_stats.published), DLOG_U(s_stats.spooled), DLOG_U(s_stats.replayed),
+                  DLOG_U(s_stats.dropped));
+        }
+        vTaskDelay(pdMS_TO_TICKS(TASK_PERIOD_MS));
+    }
+}
+
+esp_err_t mqtt_telemetry_start(void)
+{
+    uint8_t mac[6];
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    snprintf(s_client_id, sizeof(s_client_id), "%02x%02x%02x%02x%02x%02x",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    snprintf(s_topic, sizeof(s_topic), "%s/%s/samples", CONFIG_MQTT_TELEMETRY_TOPIC_PREFIX, s_client_id);
+    snprintf(s_status_topic, sizeof(s_status_topic), "%s/%s/status", CONFIG_MQTT_TELEMETRY_TOPIC_PREFIX,
+             s_client_id);
+    snprintf(s_events_topic, sizeof(s_events_topic), "%s/%s/events", CONFIG_MQTT_TELEMETRY_TOPIC_PREFIX,
+             s_client_id);
+    s_boot_id = (uint16_t)esp_random();
+
+    const esp_mqtt_client_config_t config = {
+        .broker.address.uri = CONFIG_MQTT_TELEMETRY_BROKER_URI,
+        .credentials.client_id = s_client_id,
+        .session.last_will = {
+            .topic = s_status_topic,
+            .msg = "offline",
+            .qos = 1,
+            .retain = 1,
+        },
+    };
+    s_client = esp_mqtt_client_init(&config);
+    if (!s_client) {
+        return ESP_FAIL;
+    }
+    esp_mqtt_client_register_event(s_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+
+    // Below the sampling and display tasks: publishing and SD spooling can wait
+    s_task = xTaskCreateStatic(mqtt_pub_task, "mqtt_pub", CONFIG_MQTT_TELEMETRY_TASK_STACK, NULL, 1,
+                               s_task_stack, &s_task_tcb);
+    if (!s_task) {
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Publishing to %s (boot %04x)", s_topic, s_boot_id);
+    return esp_mqtt_client_start(s_client);
+}
+
+void mqtt_telemetry_get_stats(mqtt_telemetry_stats_t *out)
+{
+    *out = s_stats;
+}
+
+#else // !CONFIG_MQTT_TELEMETRY_ENABLE
+
+esp_err_t mqtt_telemetry_start(void)
+{
+    return ESP_OK;
+}
+
+void mqtt_telemetry_get_stats(mqtt_telemetry_stats_t *out)
+{
+    *out = (mqtt_telemetry_stats_t){ 0 };
+}
+
+#endif
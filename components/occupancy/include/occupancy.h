@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+#include "sample_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Occupancy detection on the sample stream.
+ *
+ * A target is present after readings stay below CONFIG_OCCUPANCY_ENTER_CM for the
+ * enter dwell and debounce count, and absent again after they stay above
+ * CONFIG_OCCUPANCY_EXIT_CM (or out of range) for the exit dwell. Every change is
+ * appended to a small event ring; readers follow it with private cursors, like
+ * sample_ring, and never consume events for each other.
+ */
+
+typedef enum {
+    OCCUPANCY_EVENT_APPROACH = 1,   // Target arrived
+    OCCUPANCY_EVENT_DWELL = 2,      // Still present (periodic)
+    OCCUPANCY_EVENT_LEAVE = 3,      // Target left; dwell_ms is the whole stay
+} occupancy_event_type_t;
+
+// One event (16 bytes)
+typedef struct {
+    uint32_t seq;           // Event number since boot
+    uint32_t t_ms;          // When the threshold was crossed (esp_timer ms), or the report time for DWELL
+    uint32_t dwell_ms;      // Time present so far; 0 for APPROACH
+    uint16_t distance_mm;   // Closest reading of the stay (APPROACH: the crossing reading)
+    uint8_t type;           // occupancy_event_type_t
+    uint8_t reserved;
+} occupancy_event_t;
+
+// Reader position; set next to an event seq to resume after it
+typedef struct {
+    uint32_t next;          // Seq of the next event to read
+    uint32_t dropped;       // Events overwritten before this reader got to them
+} occupancy_cursor_t;
+
+typedef struct {
+    uint32_t approaches;
+    uint32_t leaves;
+    uint32_t rejected;      // State changes cancelled by debounce or dwell (chatter)
+    bool present;
+} occupancy_stats_t;
+
+// Static RAM taken by the event ring
+#define OCCUPANCY_RAM_BYTES (CONFIG_OCCUPANCY_LOG_EVENTS * sizeof(occupancy_event_t))
+
+/**
+ * @brief Run the detector on one reading (a single task only, led_task)
+ *
+ * @param item Reading from the sample ring, in sequence order
+ * @return true while a target is present
+ */
+bool occupancy_update(const sample_ring_item_t *item);
+
+/**
+ * @brief Current debounced state
+ */
+bool occupancy_present(void);
+
+/**
+ * @brief Position a cursor so that at most @p backlog existing events are read
+ *
+ * @param cursor Cursor to initialise
+ * @param backlog Number of most recent events to include (0 = only new ones)
+ */
+void occupancy_cursor_init(occupancy_cursor_t *cursor, size_t backlog);
+
+/**
+ * @brief Copy the next event for this reader
+ *
+ * @param cursor Reader cursor
+ * @param out Event copy
+ * @return true if an event was returned, false if the reader is caught up
+ */
+bool occupancy_read(occupancy_cursor_t *cursor, occupancy_event_t *out);
+
+/**
+ * @brief Counters since boot
+ */
+void occupancy_get_stats(occupancy_stats_t *out);
+
+/**
+ * @brief Event type name ("approach", "dwell", "leave")
+ */
+const char *occupancy_event_name(uint8_t type);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,194 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "occupancy.h"
+#include "freertos/FreeRTOS.h"
+#include "dlog.h"
+
+#define LOG_SIZE    CONFIG_OCCUPANCY_LOG_EVENTS
+#define LOG_MASK    (LOG_SIZE - 1)
+#define ENTER_CM    ((float)CONFIG_OCCUPANCY_ENTER_CM)
+#define EXIT_CM     ((float)CONFIG_OCCUPANCY_EXIT_CM)
+#define REPORT_US   (CONFIG_OCCUPANCY_DWELL_REPORT_S * 1000000LL)
+
+_Static_assert((LOG_SIZE & LOG_MASK) == 0, "CONFIG_OCCUPANCY_LOG_EVENTS must be a power of two");
+_Static_assert(CONFIG_OCCUPANCY_EXIT_CM >= CONFIG_OCCUPANCY_ENTER_CM,
+               "CONFIG_OCCUPANCY_EXIT_CM must not be below CONFIG_OCCUPANCY_ENTER_CM");
+
+typedef enum {
+    STATE_CLEAR,
+    STATE_ENTERING,     // Below the enter threshold, not confirmed yet
+    STATE_PRESENT,
+    STATE_LEAVING,      // Above the exit threshold, not confirmed yet
+} state_t;
+
+static occupancy_event_t s_log[LOG_SIZE];
+static uint32_t s_head;     // Events appended so far
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Detector state: only touched by the task calling occupancy_update()
+static state_t s_state;
+static uint8_t s_streak;        // Consecutive readings on the new side
+static int64_t s_since_us;      // First of those readings
+static float s_cross_cm;        // Reading that started a pending approach
+static int64_t s_enter_us;      // Start of the current stay
+static float s_closest_cm;
+static int64_t s_next_report_us;
+static occupancy_stats_t s_stats;
+
+static uint16_t to_mm(float cm)
+{
+    float mm = cm * 10.0f + 0.5f;
+    return mm > 65535.0f ? 65535 : (uint16_t)mm;
+}
+
+static void emit(occupancy_event_type_t type, int64_t t_us, int64_t dwell_us, float distance_cm)
+{
+    occupancy_event_t ev = {
+        .t_ms = (uint32_t)(t_us / 1000),
+        .dwell_ms = (uint32_t)(dwell_us / 1000),
+        .distance_mm = to_mm(distance_cm),
+        .type = (uint8_t)type,
+    };
+    portENTER_CRITICAL(&s_lock);
+    ev.seq = s_head;
+    s_log[s_head & LOG_MASK] = ev;
+    s_head++;
+    portEXIT_CRITICAL(&s_lock);
+    // dlog has no %s: one format string (= message ID) per event type
+    static const char *const fmts[] = {
+        [OCCUPANCY_EVENT_APPROACH] = "occupancy: approach, %.1f cm, dwell %lu ms",
+        [OCCUPANCY_EVENT_DWELL] = "occupancy: dwell, %.1f cm, dwell %lu ms",
+        [OCCUPANCY_EVENT_LEAVE] = "occupancy: leave, %.1f cm, dwell %lu ms",
+    };
+    DLOGI(DLOG_MOD_LED, fmts[type], DLOG_F(distance_cm), DLOG_U(ev.dwell_ms));
+}
+
+// A pending change becomes real once it has both the debounce count and the dwell time
+static bool confirmed(int64_t t_us, uint32_t dwell_ms)
+{
+    return s_streak >= CONFIG_OCCUPANCY_DEBOUNCE_SAMPLES && t_us - s_since_us >= dwell_ms * 1000LL;
+}
+
+bool occupancy_update(const sample_ring_item_t *item)
+{
+    int64_t t = item->t_us;
+    bool near = item->valid && item->distance < ENTER_CM;
+    // Out of range counts as far: a target walking away ends up beyond the sensor's reach
+    bool far = !item->valid || item->distance > EXIT_CM;
+
+    switch (s_state) {
+        case STATE_CLEAR:
+            if (!near) {
+                break;
+            }
+            s_state = STATE_ENTERING;
+            s_streak = 0;
+            s_since_us = t;
+            s_cross_cm = item->distance;
+            // fall through
+        case STATE_ENTERING:
+            if (!near) {
+                s_state = STATE_CLEAR;
+                s_stats.rejected++;
+                break;
+            }
+            if (s_streak < UINT8_MAX) s_streak++;
+            if (confirmed(t, CONFIG_OCCUPANCY_ENTER_MS)) {
+                s_state = STATE_PRESENT;
+                s_stats.present = true;
+                s_stats.approaches++;
+                s_enter_us = s_since_us;
+                s_closest_cm = item->distance < s_cross_cm ? item->distance : s_cross_cm;
+                s_next_report_us = s_enter_us + REPORT_US;
+                emit(OCCUPANCY_EVENT_APPROACH, s_enter_us, 0, s_cross_cm);
+            }
+            break;
+
+        case STATE_PRESENT:
+            if (far) {
+                s_state = STATE_LEAVING;
+                s_streak = 0;
+                s_since_us = t;
+            }
+            // fall through
+        case STATE_LEAVING:
+            if (!far) {
+                // Back inside the exit threshold (the band between the thresholds still counts)
+                if (s_state == STATE_LEAVING) {
+                    s_state = STATE_PRESENT;
+                    s_stats.rejected++;
+                }
+                if (item->distance < s_closest_cm) {
+                    s_closest_cm = item->distance;
+                }
+                if (REPORT_US > 0 && t >= s_next_report_us) {
+                    emit(OCCUPANCY_EVENT_DWELL, t, t - s_enter_us, s_closest_cm);
+                    s_next_report_us += REPORT_US;
+                }
+                break;
+            }
+            if (s_streak < UINT8_MAX) s_streak++;
+            if (confirmed(t, CONFIG_OCCUPANCY_EXIT_MS)) {
+                s_state = STATE_CLEAR;
+                s_stats.present = false;
+                s_stats.leaves++;
+                emit(OCCUPANCY_EVENT_LEAVE, s_since_us, s_since_us - s_enter_us, s_closest_cm);
+            }
+            break;
+    }
+    return s_stats.present;
+}
+
+bool occupancy_present(void)
+{
+    return s_stats.present;
+}
+
+void occupancy_cursor_init(occupancy_cursor_t *cursor, size_t backlog)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint32_t head = s_head;
+    portEXIT_CRITICAL(&s_lock);
+    if (backlog > LOG_SIZE) backlog = LOG_SIZE;
+    cursor->next = (head > backlog) ? head - (uint32_t)backlog : 0;
+    cursor->dropped = 0;
+}
+
+bool occupancy_read(occupancy_cursor_t *cursor, occupancy_event_t *out)
+{
+    bool ok = false;
+    portENTER_CRITICAL(&s_lock);
+    if (cursor->next > s_head) {
+        // Resumed from a seq of an earlier boot: start over
+        cursor->next = 0;
+    }
+    if (s_head - cursor->next > LOG_SIZE) {
+        cursor->dropped += s_head - LOG_SIZE - cursor->next;
+        cursor->next = s_head - LOG_SIZE;
+    }
+    if (cursor->next != s_head) {
+        *out = s_log[cursor->next & LOG_MASK];
+        cursor->next++;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return ok;
+}
+
+void occupancy_get_stats(occupancy_stats_t *out)
+{
+    *out = s_stats;
+}
+
+const char *occupancy_event_name(uint8_t type)
+{
+    switch (type) {
+        case OCCUPANCY_EVENT_APPROACH: return "approach";
+        case OCCUPANCY_EVENT_DWELL:    return "dwell";
+        case OCCUPANCY_EVENT_LEAVE:    return "leave";
+        default:                       return "?";
+    }
+}
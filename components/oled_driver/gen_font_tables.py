@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2025
+# SPDX-License-Identifier: CC0-1.0
+"""Generate the scaled MEDIUM (2x) and LARGE (3x) glyph tables from font5x7.h.
+
+Each output column is one integer with bit 0 = top row, ready to be shifted into
+the page-organised framebuffer by the blitter in oled_driver.c.
+
+    gen_font_tables.py font5x7.h oled_fonts_scaled.h
+"""
+import re
+import sys
+
+GLYPH_ROWS = 7  # draw_char has always ignored bit 7 of the 5x7 table
+
+SCALES = [
+    # name, factor, C column type
+    ('medium', 2, 'uint16_t'),
+    ('large', 3, 'uint32_t'),
+]
+
+
+def parse_font(path):
+    text = open(path, encoding='utf-8').read()
+    body = re.search(r'font5x7\s*\[\s*96\s*\]\s*\[\s*5\s*\]\s*=\s*\{(.*?)\n\};', text, re.S)
+    if not body:
+        sys.exit(f'{path}: font5x7[96][5] table not found')
+    glyphs = []
+    for row in re.finditer(r'\{([^}]*)\}\s*,?\s*//\s*(.*)', body.group(1)):
+        cols = [int(v, 0) for v in row.group(1).split(',')]
+        if len(cols) != 5:
+            sys.exit(f'{path}: bad glyph row "{row.group(0)}"')
+        glyphs.append((cols, row.group(2).strip()))
+    if len(glyphs) != 96:
+        sys.exit(f'{path}: expected 96 glyphs, found {len(glyphs)}')
+    return glyphs
+
+
+def scale_column(col, factor):
+    out = 0
+    for j in range(GLYPH_ROWS):
+        if col & (1 << j):
+            out |= ((1 << factor) - 1) << (j * factor)
+    return out
+
+
+def emit_table(name, factor, ctype, glyphs):
+    cols = 5 * factor
+    digits = (GLYPH_ROWS * factor + 3) // 4
+    lines = [f'#define OLED_FONT_{name.upper()}_COLS {cols}',
+             f'static const {ctype} font_{name}[96][{cols}] = {{']
+    for i, (glyph, comment) in enumerate(glyphs):
+        scaled = []
+        for col in glyph:
+            scaled += [scale_column(col, factor)] * factor
+        values = ', '.join(f'0x{v:0{digits}x}' for v in scaled)
+        sep = ',' if i < len(glyphs) - 1 else ''
+        lines.append(f'    {{{values}}}{sep} // {comment}')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    glyphs = parse_font(sys.argv[1])
+    parts = [
+        '// Generated by gen_font_tables.py from font5x7.h - do not edit',
+        '#pragma once',
+        '',
+        '#include <stdint.h>',
+        '',
+    ]
+    for name, factor, ctype in SCALES:
+        parts.append(emit_table(name, factor, ctype, glyphs))
+        parts.append('')
+    with open(sys.argv[2], 'w', encoding='utf-8') as f:
+        f.write('\n'.join(parts))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,26 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include "oled_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Time the drawing primitives on the framebuffer and log microseconds per call
+ *
+ * Only the RAM framebuffer is touched while timing; afterwards the screen is
+ * cleared and flushed once, so call it before the display task starts drawing.
+ *
+ * @param driver Driver handle
+ */
+void oled_bench_run(oled_driver_t *driver);
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,15 +5,26 @@
 
  #pragma once
 
+ #include <stdint.h>
+ #include <stdbool.h>
+ #include "sdkconfig.h"
  #include "esp_err.h"
- #include "esp_lcd_panel_io.h"
- #include "esp_lcd_panel_ops.h"
- #include "driver/i2c_master.h"
  
  #ifdef __cplusplus
  extern "C" {
  #endif
  
+ #if CONFIG_OLED_DRIVER_ASYNC_FLUSH
+ #define OLED_DRIVER_FB_COUNT 2     // Back buffer for drawing, front buffer for the flush task
+ #else
+ #define OLED_DRIVER_FB_COUNT 1
+ #endif
+ 
+ #if CONFIG_OLED_DRIVER_STATIC_ALLOC
+ // Static framebuffer size, for RAM budget accounting
+ #define OLED_DRIVER_FB_BYTES (CONFIG_OLED_DRIVER_MAX_WIDTH * CONFIG_OLED_DRIVER_MAX_HEIGHT / 8 * OLED_DRIVER_FB_COUNT)
+ #endif
+ 
  // OLED Driver Configuration
  typedef struct {
      int sda_pin;           // SDA pin number
@@ -39,9 +50,41 @@
      OLED_FONT_LARGE
  } oled_font_t;
  
+ // Flush counters (bytes are framebuffer bytes sent to the panel, excluding commands)
+ typedef struct {
+     uint32_t flushes;          // Flushes that reached the panel
+     uint32_t transfers;        // Panel draw() windows
+     uint32_t bytes;            // Pixel bytes sent
+     uint32_t frames;           // Commits handed to the flush task (async mode)
+     uint32_t dropped;          // Commits merged into a later one because the bus was busy
+     uint32_t latency_last_us;  // Commit to end of transfer, last frame
+     uint32_t latency_max_us;
+     uint32_t latency_avg_us;
+ } oled_stats_t;
+ 
+ // Pixel rectangle
+ typedef struct {
+     int x;
+     int y;
+     int w;
+     int h;
+ } oled_rect_t;
+ 
  // OLED Driver Handle
  typedef struct oled_driver_t oled_driver_t;
  
+ // Panel backend. The driver only renders into its page-organised framebuffer and
+ // hands changed windows to these callbacks; backends embed this struct as their
+ // first member (SSD1306 over esp_lcd on the device, an in-memory panel on linux).
+ typedef struct oled_panel_t oled_panel_t;
+ struct oled_panel_t {
+     // Window [x0, x1) x [y0, y1), y0/y1 multiples of 8: (x1 - x0) bytes per page, pages back to back
+     esp_err_t (*draw)(oled_panel_t *panel, int x0, int y0, int x1, int y1, const uint8_t *data);
+     esp_err_t (*invert)(oled_panel_t *panel, bool invert);
+     esp_err_t (*swap_xy)(oled_panel_t *panel, bool swap);
+     void (*del)(oled_panel_t *panel);
+ };
+ 
  /**
   * @brief Initialize OLED driver
   * 
@@ -51,6 +94,37 @@
   */
  esp_err_t oled_init(const oled_config_t *config, oled_driver_t **driver);
  
+ /**
+  * @brief Initialize OLED driver on an already created panel backend
+  *
+  * oled_init() calls this with the SSD1306 panel (or the host panel on the linux
+  * target). Only width and height of @p config are used. The driver takes ownership
+  * of @p panel and deletes it in oled_deinit().
+  *
+  * @param config Configuration structure
+  * @param panel Panel backend
+  * @param driver Pointer to store driver handle
+  * @return esp_err_t ESP_OK on success
+  */
+ esp_err_t oled_init_with_panel(const oled_config_t *config, oled_panel_t *panel, oled_driver_t **driver);
+ 
+ /**
+  * @brief Panel backend the driver sends to
+  *
+  * @param driver Driver handle
+  * @return oled_panel_t* Panel, e.g. for oled_panel_host_write_pbm()
+  */
+ oled_panel_t *oled_get_panel(oled_driver_t *driver);
+ 
+ /**
+  * @brief Create the SSD1306 I2C panel (device targets only)
+  *
+  * @param config Pins, I2C address/clock and panel height
+  * @param panel Pointer to store the panel
+  * @return esp_err_t ESP_OK on success
+  */
+ esp_err_t oled_panel_new_ssd1306(const oled_config_t *config, oled_panel_t **panel);
+ 
  /**
   * @brief Deinitialize OLED driver
   * 
@@ -81,6 +155,18 @@
  esp_err_t oled_display_text(oled_driver_t *driver, const char *text, int x, int y, 
                             oled_font_t font, oled_align_t align);
  
+ /**
+  * @brief Compute the pixels oled_display_text() would touch, without drawing
+  *
+  * @param text Text to measure
+  * @param x X position as passed to oled_display_text()
+  * @param y Y position
+  * @param font Font size
+  * @param align Text alignment
+  * @param box Drawn bounding box (w = h = 0 for empty text)
+  */
+ void oled_text_box(const char *text, int x, int y, oled_font_t font, oled_align_t align, oled_rect_t *box);
+ 
  /**
   * @brief Display text with auto line wrapping
   * 
@@ -135,13 +221,107 @@
                               int filled, int color);
  
  /**
-  * @brief Update display (send buffer to screen)
+  * @brief Draw a horizontal line (byte-wise, one masked byte per column)
+  *
+  * @param driver Driver handle
+  * @param x Start X position
+  * @param y Y position
+  * @param width Length in pixels
+  * @param color 1 for white, 0 for black
+  * @return esp_err_t ESP_OK on success
+  */
+ esp_err_t oled_draw_hline(oled_driver_t *driver, int x, int y, int width, int color);
+ 
+ /**
+  * @brief Draw a vertical line (one masked byte per page)
+  *
+  * @param driver Driver handle
+  * @param x X position
+  * @param y Start Y position
+  * @param height Length in pixels
+  * @param color 1 for white, 0 for black
+  * @return esp_err_t ESP_OK on success
+  */
+ esp_err_t oled_draw_vline(oled_driver_t *driver, int x, int y, int height, int color);
+ 
+ /**
+  * @brief Clear a rectangular region to black (memset per page row plus masked edges)
+  *
+  * @param driver Driver handle
+  * @param x X position
+  * @param y Y position
+  * @param width Region width
+  * @param height Region height
+  * @return esp_err_t ESP_OK on success
+  */
+ esp_err_t oled_clear_region(oled_driver_t *driver, int x, int y, int width, int height);
+ 
+ /**
+  * @brief Shift a region left by n columns; the n columns freed on the right are cleared
+  *
+  * Pixels outside the region are preserved, so a graph can scroll under fixed labels.
+  *
+  * @param driver Driver handle
+  * @param x X position
+  * @param y Y position
+  * @param width Region width
+  * @param height Region height
+  * @param n Columns to shift
+  * @return esp_err_t ESP_OK on success
+  */
+ esp_err_t oled_scroll_left(oled_driver_t *driver, int x, int y, int width, int height, int n);
+ 
+ /**
+  * @brief Update display (send the changed page windows to the screen)
+  *
+  * Only column spans touched since the last update are transferred. Inside a
+  * frame this is a no-op; the flush happens at oled_end_frame(). With
+  * CONFIG_OLED_DRIVER_ASYNC_FLUSH the windows are copied to the front buffer and
+  * sent by the flush task; the call returns without waiting for the bus.
   * 
   * @param driver Driver handle
   * @return esp_err_t ESP_OK on success
   */
  esp_err_t oled_update(oled_driver_t *driver);
  
+ /**
+  * @brief Start a frame: drawing calls no longer flush on their own
+  *
+  * Frames nest; only the outermost oled_end_frame() sends the changed windows.
+  *
+  * @param driver Driver handle
+  * @return esp_err_t ESP_OK on success
+  */
+ esp_err_t oled_begin_frame(oled_driver_t *driver);
+ 
+ /**
+  * @brief End a frame and flush the pages changed since the last flush
+  *
+  * @param driver Driver handle
+  * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE without a matching begin
+  */
+ esp_err_t oled_end_frame(oled_driver_t *driver);
+ 
+ /**
+  * @brief Wait until the flush task has sent the last committed frame
+  *
+  * Returns immediately when CONFIG_OLED_DRIVER_ASYNC_FLUSH is off.
+  *
+  * @param driver Driver handle
+  * @param timeout_ms Maximum wait
+  * @return esp_err_t ESP_OK when idle, ESP_ERR_TIMEOUT otherwise
+  */
+ esp_err_t oled_flush_wait(oled_driver_t *driver, uint32_t timeout_ms);
+ 
+ /**
+  * @brief Read flush counters
+  *
+  * @param driver Driver handle
+  * @param stats Destination
+  * @return esp_err_t ESP_OK on success
+  */
+ esp_err_t oled_get_stats(oled_driver_t *driver, oled_stats_t *stats);
+ 
  /**
   * @brief Set display brightness
   * 
@@ -156,7 +336,7 @@
   * 
   * @param driver Driver handle
   * @param invert 1 to invert, 0 for normal
-  * @return esp_err_t ESP_OK on success
+  * @return esp_err_t ESP_OK on success, ESP_ERR_TIMEOUT if the previous frame is still being sent
   */
  esp_err_t oled_invert(oled_driver_t *driver, int invert);
  
@@ -165,7 +345,7 @@
   * 
   * @param driver Driver handle
   * @param rotation 0, 90, 180, or 270 degrees
-  * @return esp_err_t ESP_OK on success
+  * @return esp_err_t ESP_OK on success, ESP_ERR_TIMEOUT if the previous frame is still being sent
   */
  esp_err_t oled_rotate(oled_driver_t *driver, int rotation);
  
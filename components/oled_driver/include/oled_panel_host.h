@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "oled_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * In-memory panel for the ESP-IDF linux target.
+ *
+ * Keeps a copy of panel RAM in the SSD1306 page layout, written only through the
+ * windows the driver flushes, so a dump shows exactly what the device would
+ * display (including a missed dirty span). Images are binary PBM (P4, 1 = black),
+ * viewable as-is or convertible with `convert screen.pbm screen.png`.
+ */
+
+/**
+ * @brief Create an in-memory panel (all pixels off)
+ *
+ * @param width Panel width
+ * @param height Panel height, multiple of 8
+ * @param panel Pointer to store the panel
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t oled_panel_new_host(int width, int height, oled_panel_t **panel);
+
+/**
+ * @brief Read one pixel as displayed (inversion applied)
+ *
+ * @return true if the pixel is lit
+ */
+bool oled_panel_host_get_pixel(const oled_panel_t *panel, int x, int y);
+
+/**
+ * @brief Write the panel content as a binary PBM image
+ *
+ * @param panel Host panel
+ * @param path Output file
+ * @return esp_err_t ESP_FAIL if the file cannot be written
+ */
+esp_err_t oled_panel_host_write_pbm(const oled_panel_t *panel, const char *path);
+
+/**
+ * @brief Compare the panel content with a PBM image
+ *
+ * @param panel Host panel
+ * @param path Reference image
+ * @param diff_pixels Number of pixels that differ
+ * @return esp_err_t ESP_ERR_NOT_FOUND if the image is missing, ESP_ERR_INVALID_SIZE if
+ *         its size differs from the panel, ESP_ERR_INVALID_RESPONSE if it is not a P4 PBM
+ */
+esp_err_t oled_panel_host_diff_pbm(const oled_panel_t *panel, const char *path, uint32_t *diff_pixels);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,91 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "oled_bench.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "oled_bench";
+
+#define BENCH_ITERATIONS 200
+
+typedef void (*bench_fn_t)(oled_driver_t *driver);
+
+// Reference: the old filled-rectangle path, one oled_draw_pixel() per pixel
+static void bench_pixel_fill(oled_driver_t *driver)
+{
+    for (int y = 35; y < 60; y++) {
+        for (int x = 5; x < 123; x++) {
+            oled_draw_pixel(driver, x, y, 0);
+        }
+    }
+}
+
+// The 118x25 area display_task clears every refresh
+static void bench_fill_rect(oled_driver_t *driver)
+{
+    oled_draw_rectangle(driver, 5, 35, 118, 25, 1, 0);
+}
+
+static void bench_clear_region(oled_driver_t *driver)
+{
+    oled_clear_region(driver, 0, 3, 128, 58);
+}
+
+static void bench_hline(oled_driver_t *driver)
+{
+    oled_draw_hline(driver, 0, 30, 128, 1);
+}
+
+static void bench_vline(oled_driver_t *driver)
+{
+    oled_draw_vline(driver, 64, 3, 58, 1);
+}
+
+static void bench_outline(oled_driver_t *driver)
+{
+    oled_draw_rectangle(driver, 2, 2, 124, 60, 0, 1);
+}
+
+static void bench_text(oled_driver_t *driver)
+{
+    oled_display_text(driver, "Distance: 123.4 cm", 64, 40, OLED_FONT_SMALL, OLED_ALIGN_CENTER);
+}
+
+static void bench_text_large(oled_driver_t *driver)
+{
+    oled_display_text(driver, "123.4", 64, 20, OLED_FONT_LARGE, OLED_ALIGN_CENTER);
+}
+
+static const struct {
+    const char *name;
+    bench_fn_t fn;
+} s_cases[] = {
+    { "pixel fill 118x25", bench_pixel_fill },
+    { "fill rect 118x25", bench_fill_rect },
+    { "clear region 128x58", bench_clear_region },
+    { "hline 128", bench_hline },
+    { "vline 58", bench_vline },
+    { "outline 124x60", bench_outline },
+    { "text small x18", bench_text },
+    { "text large x5", bench_text_large },
+};
+
+void oled_bench_run(oled_driver_t *driver)
+{
+    // Text calls must not flush to the panel while being timed
+    oled_begin_frame(driver);
+    for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        s_cases[i].fn(driver);  // Warm the cache
+        int64_t start = esp_timer_get_time();
+        for (int n = 0; n < BENCH_ITERATIONS; n++) {
+            s_cases[i].fn(driver);
+        }
+        int64_t elapsed = esp_timer_get_time() - start;
+        ESP_LOGI(TAG, "%-20s %6.2f us/call", s_cases[i].name, (double)elapsed / BENCH_ITERATIONS);
+    }
+    oled_clear(driver);
+    oled_end_frame(driver);
+}
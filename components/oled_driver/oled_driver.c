@@ -5,126 +5,123 @@
 
 #include "oled_driver.h"
 #include "esp_log.h"
-#include "esp_lcd_panel_vendor.h"
-#include "esp_lcd_panel_ssd1306.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <sys/param.h>
+#include "font5x7.h"
+#include "oled_fonts_scaled.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include "oled_panel_host.h"
+#endif
  
  static const char *TAG = "oled_driver";
  
+ // Bound for waiting on the flush task; a full frame over 400 kHz I2C takes ~25 ms
+ #define FLUSH_WAIT_MS 1000
+ 
+ #if CONFIG_OLED_DRIVER_STATIC_ALLOC
+ #define OLED_MAX_PAGES (CONFIG_OLED_DRIVER_MAX_HEIGHT / 8)
+ #else
+ #define OLED_MAX_PAGES 16      // SSD1306/SH1106 family tops out at 128 rows
+ #endif
+ 
  // OLED Driver structure
  struct oled_driver_t {
-     i2c_master_bus_handle_t i2c_bus;
-     esp_lcd_panel_io_handle_t io_handle;
-     esp_lcd_panel_handle_t panel_handle;
+     oled_panel_t *panel;
      uint8_t *buffer;
      int width;
      int height;
      int rotation;
      int inverted;
+     int pages;                         // height / 8
+     int frame_depth;                   // > 0 between oled_begin_frame() and oled_end_frame()
+     int16_t dirty_x0[OLED_MAX_PAGES];  // Changed column span per page, [x0, x1)
+     int16_t dirty_x1[OLED_MAX_PAGES];  // x0 >= x1 means the page is clean
+     oled_stats_t stats;
+ #if CONFIG_OLED_DRIVER_ASYNC_FLUSH
+     uint8_t *front;                    // Snapshot owned by the flush task
+     int16_t flush_x0[OLED_MAX_PAGES];  // Windows of the snapshot to send
+     int16_t flush_x1[OLED_MAX_PAGES];
+     TaskHandle_t flush_task;
+     SemaphoreHandle_t flush_idle;      // Available while the flush task has nothing to send
+     StaticSemaphore_t flush_idle_buf;
+     int64_t commit_us;
+     uint64_t latency_sum_us;
+     volatile bool resend_all;          // Set by the flush task after a failed transfer
+ #endif
  };
  
- // Simple font data (5x7 pixels)
- static const uint8_t font5x7[96][5] = {
-     {0x00, 0x00, 0x00, 0x00, 0x00}, // space
-     {0x00, 0x00, 0x5f, 0x00, 0x00}, // !
-     {0x00, 0x07, 0x00, 0x07, 0x00}, // "
-     {0x14, 0x7f, 0x14, 0x7f, 0x14}, // #
-     {0x24, 0x2a, 0x7f, 0x2a, 0x12}, // $
-     {0x23, 0x13, 0x08, 0x64, 0x62}, // %
-     {0x36, 0x49, 0x55, 0x22, 0x50}, // &
-     {0x00, 0x05, 0x03, 0x00, 0x00}, // '
-     {0x00, 0x1c, 0x22, 0x41, 0x00}, // (
-     {0x00, 0x41, 0x22, 0x1c, 0x00}, // )
-     {0x14, 0x08, 0x3e, 0x08, 0x14}, // *
-     {0x08, 0x08, 0x3e, 0x08, 0x08}, // +
-     {0x00, 0x00, 0xa0, 0x60, 0x00}, // ,
-     {0x08, 0x08, 0x08, 0x08, 0x08}, // -
-     {0x00, 0x60, 0x60, 0x00, 0x00}, // .
-     {0x20, 0x10, 0x08, 0x04, 0x02}, // /
-     {0x3e, 0x51, 0x49, 0x45, 0x3e}, // 0
-     {0x00, 0x42, 0x7f, 0x40, 0x00}, // 1
-     {0x42, 0x61, 0x51, 0x49, 0x46}, // 2
-     {0x21, 0x41, 0x45, 0x4b, 0x31}, // 3
-     {0x18, 0x14, 0x12, 0x7f, 0x10}, // 4
-     {0x27, 0x45, 0x45, 0x45, 0x39}, // 5
-     {0x3c, 0x4a, 0x49, 0x49, 0x30}, // 6
-     {0x01, 0x71, 0x09, 0x05, 0x03}, // 7
-     {0x36, 0x49, 0x49, 0x49, 0x36}, // 8
-     {0x06, 0x49, 0x49, 0x29, 0x1e}, // 9
-     {0x00, 0x36, 0x36, 0x00, 0x00}, // :
-     {0x00, 0x56, 0x36, 0x00, 0x00}, // ;
-     {0x08, 0x14, 0x22, 0x41, 0x00}, // <
-     {0x14, 0x14, 0x14, 0x14, 0x14}, // =
-     {0x00, 0x41, 0x22, 0x14, 0x08}, // >
-     {0x02, 0x01, 0x51, 0x09, 0x06}, // ?
-     {0x32, 0x49, 0x79, 0x41, 0x3e}, // @
-     {0x7e, 0x11, 0x11, 0x11, 0x7e}, // A
-     {0x7f, 0x49, 0x49, 0x49, 0x36}, // B
-     {0x3e, 0x41, 0x41, 0x41, 0x22}, // C
-     {0x7f, 0x41, 0x41, 0x22, 0x1c}, // D
-     {0x7f, 0x49, 0x49, 0x49, 0x41}, // E
-     {0x7f, 0x09, 0x09, 0x09, 0x01}, // F
-     {0x3e, 0x41, 0x49, 0x49, 0x7a}, // G
-     {0x7f, 0x08, 0x08, 0x08, 0x7f}, // H
-     {0x00, 0x41, 0x7f, 0x41, 0x00}, // I
-     {0x20, 0x40, 0x41, 0x3f, 0x01}, // J
-     {0x7f, 0x08, 0x14, 0x22, 0x41}, // K
-     {0x7f, 0x40, 0x40, 0x40, 0x40}, // L
-     {0x7f, 0x02, 0x0c, 0x02, 0x7f}, // M
-     {0x7f, 0x04, 0x08, 0x10, 0x7f}, // N
-     {0x3e, 0x41, 0x41, 0x41, 0x3e}, // O
-     {0x7f, 0x09, 0x09, 0x09, 0x06}, // P
-     {0x3e, 0x41, 0x51, 0x21, 0x5e}, // Q
-     {0x7f, 0x09, 0x19, 0x29, 0x46}, // R
-     {0x46, 0x49, 0x49, 0x49, 0x31}, // S
-     {0x01, 0x01, 0x7f, 0x01, 0x01}, // T
-     {0x3f, 0x40, 0x40, 0x40, 0x3f}, // U
-     {0x1f, 0x20, 0x40, 0x20, 0x1f}, // V
-     {0x3f, 0x40, 0x38, 0x40, 0x3f}, // W
-     {0x63, 0x14, 0x08, 0x14, 0x63}, // X
-     {0x07, 0x08, 0x70, 0x08, 0x07}, // Y
-     {0x61, 0x51, 0x49, 0x45, 0x43}, // Z
-     {0x00, 0x7f, 0x41, 0x41, 0x00}, // [
-     {0x02, 0x04, 0x08, 0x10, 0x20}, // backslash
-     {0x00, 0x41, 0x41, 0x7f, 0x00}, // ]
-     {0x04, 0x02, 0x01, 0x02, 0x04}, // ^
-     {0x40, 0x40, 0x40, 0x40, 0x40}, // _
-     {0x00, 0x01, 0x02, 0x04, 0x00}, // `
-     {0x20, 0x54, 0x54, 0x54, 0x78}, // a
-     {0x7f, 0x48, 0x44, 0x44, 0x38}, // b
-     {0x38, 0x44, 0x44, 0x44, 0x20}, // c
-     {0x38, 0x44, 0x44, 0x48, 0x7f}, // d
-     {0x38, 0x54, 0x54, 0x54, 0x18}, // e
-     {0x08, 0x7e, 0x09, 0x01, 0x02}, // f
-     {0x18, 0xa4, 0xa4, 0xa4, 0x7c}, // g
-     {0x7f, 0x08, 0x04, 0x04, 0x78}, // h
-     {0x00, 0x44, 0x7d, 0x40, 0x00}, // i
-     {0x40, 0x80, 0x84, 0x7d, 0x00}, // j
-     {0x7f, 0x10, 0x28, 0x44, 0x00}, // k
-     {0x00, 0x41, 0x7f, 0x40, 0x00}, // l
-     {0x7c, 0x04, 0x18, 0x04, 0x78}, // m
-     {0x7c, 0x08, 0x04, 0x04, 0x78}, // n
-     {0x38, 0x44, 0x44, 0x44, 0x38}, // o
-     {0xfc, 0x24, 0x24, 0x24, 0x18}, // p
-     {0x18, 0x24, 0x24, 0x18, 0xfc}, // q
-     {0x7c, 0x08, 0x04, 0x04, 0x08}, // r
-     {0x48, 0x54, 0x54, 0x54, 0x20}, // s
-     {0x04, 0x3f, 0x44, 0x40, 0x20}, // t
-     {0x3c, 0x40, 0x40, 0x20, 0x7c}, // u
-     {0x1c, 0x20, 0x40, 0x20, 0x1c}, // v
-     {0x3c, 0x40, 0x30, 0x40, 0x3c}, // w
-     {0x44, 0x28, 0x10, 0x28, 0x44}, // x
-     {0x1c, 0xa0, 0xa0, 0xa0, 0x7c}, // y
-     {0x44, 0x64, 0x54, 0x4c, 0x44}, // z
-     {0x00, 0x08, 0x36, 0x41, 0x00}, // {
-     {0x00, 0x00, 0x7f, 0x00, 0x00}, // |
-     {0x00, 0x41, 0x36, 0x08, 0x00}, // }
-     {0x10, 0x08, 0x08, 0x10, 0x08}, // ~
-     {0x78, 0x46, 0x41, 0x46, 0x78}  // DEL
- };
+ #if CONFIG_OLED_DRIVER_STATIC_ALLOC
+ static oled_driver_t s_static_driver;
+ static uint8_t s_static_buffer[OLED_DRIVER_FB_BYTES];
+ static bool s_static_in_use = false;
+ #if CONFIG_OLED_DRIVER_ASYNC_FLUSH
+ static StackType_t s_flush_stack[CONFIG_OLED_DRIVER_FLUSH_TASK_STACK];
+ static StaticTask_t s_flush_tcb;
+ #endif
+ #endif
+ 
+ #if CONFIG_OLED_DRIVER_ASYNC_FLUSH
+ static void oled_flush_task(void *pvParameters);
+ #endif
+ 
+ // Extend the dirty span of every page touched by [x0, x1) x [y0, y1), clipped to the panel
+ static void mark_dirty(oled_driver_t *driver, int x0, int y0, int x1, int y1) {
+     if (x0 < 0) x0 = 0;
+     if (y0 < 0) y0 = 0;
+     if (x1 > driver->width) x1 = driver->width;
+     if (y1 > driver->height) y1 = driver->height;
+     if (x0 >= x1 || y0 >= y1) {
+         return;
+     }
+     for (int page = y0 / 8; page <= (y1 - 1) / 8; page++) {
+         if (driver->dirty_x0[page] >= driver->dirty_x1[page]) {
+             driver->dirty_x0[page] = x0;
+             driver->dirty_x1[page] = x1;
+         } else {
+             if (x0 < driver->dirty_x0[page]) driver->dirty_x0[page] = x0;
+             if (x1 > driver->dirty_x1[page]) driver->dirty_x1[page] = x1;
+         }
+     }
+ }
+ 
+ // Set or clear [x0, x1) x [y0, y1), clipped. Works a page row at a time: full bytes
+ // are a memset, the partial top/bottom bytes of a span share one mask per page.
+ static void fill_span(oled_driver_t *driver, int x0, int y0, int x1, int y1, int color) {
+     if (x0 < 0) x0 = 0;
+     if (y0 < 0) y0 = 0;
+     if (x1 > driver->width) x1 = driver->width;
+     if (y1 > driver->height) y1 = driver->height;
+     if (x0 >= x1 || y0 >= y1) {
+         return;
+     }
+ 
+     int cols = x1 - x0;
+     for (int page = y0 >> 3; page <= (y1 - 1) >> 3; page++) {
+         int top = (page == (y0 >> 3)) ? (y0 & 7) : 0;
+         int bottom = (page == ((y1 - 1) >> 3)) ? ((y1 - 1) & 7) : 7;
+         uint8_t mask = (uint8_t)((0xFF << top) & (0xFF >> (7 - bottom)));
+         uint8_t *dst = driver->buffer + page * driver->width + x0;
+         if (mask == 0xFF) {
+             memset(dst, color ? 0xFF : 0x00, cols);
+         } else if (color) {
+             for (int i = 0; i < cols; i++) dst[i] |= mask;
+         } else {
+             for (int i = 0; i < cols; i++) dst[i] &= (uint8_t)~mask;
+         }
+     }
+     mark_dirty(driver, x0, y0, x1, y1);
+ }
+ 
+ // Flush now unless a frame is open; text and clear calls go through here
+ static esp_err_t auto_update(oled_driver_t *driver) {
+     return driver->frame_depth > 0 ? ESP_OK : oled_update(driver);
+ }
  
  // Helper function to get font width
  static int get_font_width(oled_font_t font) {
@@ -136,6 +133,23 @@
      }
  }
  
+ // Drawn glyph size; scaled glyphs are wider/taller than their advance and overlap
+ static int get_glyph_width(oled_font_t font) {
+     switch (font) {
+         case OLED_FONT_MEDIUM: return OLED_FONT_MEDIUM_COLS;
+         case OLED_FONT_LARGE: return OLED_FONT_LARGE_COLS;
+         default: return 5;
+     }
+ }
+ 
+ static int get_glyph_height(oled_font_t font) {
+     switch (font) {
+         case OLED_FONT_MEDIUM: return 14;
+         case OLED_FONT_LARGE: return 21;
+         default: return 7;
+     }
+ }
+ 
  // Helper function to get font height
  static int get_font_height(oled_font_t font) {
      switch (font) {
@@ -146,47 +160,44 @@
      }
  }
  
- // Helper function to draw a character
+ // OR one glyph column (bit 0 = top row, at most 21 rows) into the page-organised
+ // framebuffer. The y % 8 offset is applied once as a shift, so a column touches at
+ // most three pages and no per-pixel divide, modulo or bounds check is needed.
+ static inline void blit_column(oled_driver_t *driver, int x, int y, uint32_t bits) {
+     if (x >= driver->width || bits == 0) {
+         return;
+     }
+     uint32_t v = bits << (y & 7);
+     uint8_t *dst = driver->buffer + (y >> 3) * driver->width + x;
+     for (int page = y >> 3; v && page < driver->pages; page++) {
+         *dst |= (uint8_t)v;
+         v >>= 8;
+         dst += driver->width;
+     }
+ }
+ 
+ // Helper function to draw a character (x, y >= 0; right/bottom edges are clipped)
  static void draw_char(oled_driver_t *driver, char c, int x, int y, oled_font_t font) {
      if (c < 32 || c > 126) return; // Only printable characters
      
-     int font_width = get_font_width(font);
-     int font_height = get_font_height(font);
-     
-     if (font == OLED_FONT_SMALL) {
-         // Use 5x7 font
-         const uint8_t *char_data = font5x7[c - 32];
-         
-         for (int i = 0; i < 5; i++) {
-             for (int j = 0; j < 7; j++) {
-                 if (x + i < driver->width && y + j < driver->height) {
-                     if (char_data[i] & (1 << j)) {
-                         oled_draw_pixel(driver, x + i, y + j, 1);
-                     }
-                 }
+     int g = c - 32;
+     switch (font) {
+         case OLED_FONT_MEDIUM:
+             for (int i = 0; i < OLED_FONT_MEDIUM_COLS; i++) {
+                 blit_column(driver, x + i, y, font_medium[g][i]);
              }
-         }
-     } else {
-         // For larger fonts, we'll scale the small font
-         int scale = (font == OLED_FONT_MEDIUM) ? 2 : 3;
-         const uint8_t *char_data = font5x7[c - 32];
-         
-         for (int i = 0; i < 5; i++) {
-             for (int j = 0; j < 7; j++) {
-                 if (char_data[i] & (1 << j)) {
-                     // Draw scaled pixel
-                     for (int si = 0; si < scale; si++) {
-                         for (int sj = 0; sj < scale; sj++) {
-                             int px = x + i * scale + si;
-                             int py = y + j * scale + sj;
-                             if (px < driver->width && py < driver->height) {
-                                 oled_draw_pixel(driver, px, py, 1);
-                             }
-                         }
-                     }
-                 }
+             break;
+         case OLED_FONT_LARGE:
+             for (int i = 0; i < OLED_FONT_LARGE_COLS; i++) {
+                 blit_column(driver, x + i, y, font_large[g][i]);
              }
-         }
+             break;
+         case OLED_FONT_SMALL:
+         default:
+             for (int i = 0; i < 5; i++) {
+                 blit_column(driver, x + i, y, font5x7[g][i] & 0x7f);
+             }
+             break;
      }
  }
  
@@ -195,63 +206,99 @@
          return ESP_ERR_INVALID_ARG;
      }
  
+     oled_panel_t *panel = NULL;
+ #if CONFIG_IDF_TARGET_LINUX
+     // No I2C on the host: render into an in-memory panel that can be dumped as PBM
+     esp_err_t ret = oled_panel_new_host(config->width, config->height, &panel);
+ #else
+     esp_err_t ret = oled_panel_new_ssd1306(config, &panel);
+ #endif
+     if (ret != ESP_OK) {
+         return ret;
+     }
+     ret = oled_init_with_panel(config, panel, driver);
+     if (ret != ESP_OK) {
+         panel->del(panel);
+     }
+     return ret;
+ }
+ 
+ // Give back the instance and its buffers (static slot or heap); the panel is not touched
+ static void release_driver(oled_driver_t *drv) {
+ #if CONFIG_OLED_DRIVER_STATIC_ALLOC
+     (void)drv;
+     s_static_in_use = false;
+ #else
+     free(drv->buffer);
+     free(drv);
+ #endif
+ }
+ 
+ esp_err_t oled_init_with_panel(const oled_config_t *config, oled_panel_t *panel, oled_driver_t **driver) {
+     if (!config || !panel || !driver) {
+         return ESP_ERR_INVALID_ARG;
+     }
+ 
+ #if CONFIG_OLED_DRIVER_STATIC_ALLOC
+     // Single static instance: no heap use, footprint fixed at link time
+     if (config->width > CONFIG_OLED_DRIVER_MAX_WIDTH || config->height > CONFIG_OLED_DRIVER_MAX_HEIGHT) {
+         return ESP_ERR_INVALID_SIZE;
+     }
+     if (s_static_in_use) {
+         return ESP_ERR_INVALID_STATE;
+     }
+     s_static_in_use = true;
+     oled_driver_t *drv = &s_static_driver;
+     memset(drv, 0, sizeof(*drv));
+     memset(s_static_buffer, 0, sizeof(s_static_buffer));
+     drv->buffer = s_static_buffer;
+ #else
+     if (config->height / 8 > OLED_MAX_PAGES) {
+         return ESP_ERR_INVALID_SIZE;
+     }
+ 
      // Allocate driver structure
      oled_driver_t *drv = calloc(1, sizeof(oled_driver_t));
      if (!drv) {
          return ESP_ERR_NO_MEM;
      }
  
+     // Allocate display buffer(s)
+     drv->buffer = calloc(OLED_DRIVER_FB_COUNT, config->width * config->height / 8);
+     if (!drv->buffer) {
+         free(drv);
+         return ESP_ERR_NO_MEM;
+     }
+ #endif
+ 
      drv->width = config->width;
      drv->height = config->height;
      drv->rotation = 0;
      drv->inverted = 0;
- 
-     // Allocate display buffer
-     drv->buffer = calloc(1, config->width * config->height / 8);
-     if (!drv->buffer) {
-         free(drv);
+     drv->pages = config->height / 8;
+     drv->panel = panel;
+     // Panel RAM content is unknown after reset: the first update sends everything
+     mark_dirty(drv, 0, 0, drv->width, drv->height);
+ 
+ #if CONFIG_OLED_DRIVER_ASYNC_FLUSH
+     // Front buffer follows the back buffer in the same allocation
+     drv->front = drv->buffer + drv->width * drv->height / 8;
+     drv->flush_idle = xSemaphoreCreateBinaryStatic(&drv->flush_idle_buf);
+     xSemaphoreGive(drv->flush_idle);
+ #if CONFIG_OLED_DRIVER_STATIC_ALLOC
+     drv->flush_task = xTaskCreateStatic(oled_flush_task, "oled_flush", CONFIG_OLED_DRIVER_FLUSH_TASK_STACK, drv,
+                                         CONFIG_OLED_DRIVER_FLUSH_TASK_PRIO, s_flush_stack, &s_flush_tcb);
+ #else
+     xTaskCreate(oled_flush_task, "oled_flush", CONFIG_OLED_DRIVER_FLUSH_TASK_STACK, drv,
+                 CONFIG_OLED_DRIVER_FLUSH_TASK_PRIO, &drv->flush_task);
+ #endif
+     if (!drv->flush_task) {
+         ESP_LOGE(TAG, "Failed to create flush task");
+         // The panel stays with the caller
+         release_driver(drv);
          return ESP_ERR_NO_MEM;
      }
- 
-     // Initialize I2C bus
-     i2c_master_bus_config_t bus_config = {
-         .clk_source = I2C_CLK_SRC_DEFAULT,
-         .glitch_ignore_cnt = 7,
-         .i2c_port = 0,
-         .sda_io_num = config->sda_pin,
-         .scl_io_num = config->scl_pin,
-         .flags.enable_internal_pullup = true,
-     };
-     ESP_ERROR_CHECK(i2c_new_master_bus(&bus_config, &drv->i2c_bus));
- 
-     // Install panel IO
-     esp_lcd_panel_io_i2c_config_t io_config = {
-         .dev_addr = config->i2c_addr,
-         .scl_speed_hz = config->pixel_clock,
-         .control_phase_bytes = 1,
-         .lcd_cmd_bits = 8,
-         .lcd_param_bits = 8,
-         .dc_bit_offset = 6,
-     };
-     ESP_ERROR_CHECK(esp_lcd_new_panel_io_i2c(drv->i2c_bus, &io_config, &drv->io_handle));
- 
-     // Install panel driver
-     esp_lcd_panel_dev_config_t panel_config = {
-         .bits_per_pixel = 1,
-         .reset_gpio_num = config->rst_pin,
-     };
-     
-     esp_lcd_panel_ssd1306_config_t ssd1306_config = {
-         .height = config->height,
-     };
-     panel_config.vendor_config = &ssd1306_config;
-     ESP_ERROR_CHECK(esp_lcd_new_panel_ssd1306(drv->io_handle, &panel_config, &drv->panel_handle));
- 
-     // Initialize panel
-     ESP_ERROR_CHECK(esp_lcd_panel_reset(drv->panel_handle));
-     ESP_ERROR_CHECK(esp_lcd_panel_init(drv->panel_handle));
-     ESP_ERROR_CHECK(esp_lcd_panel_mirror(drv->panel_handle, true, true));
-     ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(drv->panel_handle, true));
+ #endif
  
      *driver = drv;
      ESP_LOGI(TAG, "OLED driver initialized successfully");
@@ -263,31 +310,34 @@
          return ESP_ERR_INVALID_ARG;
      }
  
-     if (driver->panel_handle) {
-         esp_lcd_panel_del(driver->panel_handle);
-     }
-     if (driver->io_handle) {
-         esp_lcd_panel_io_del(driver->io_handle);
-     }
-     if (driver->i2c_bus) {
-         i2c_del_master_bus(driver->i2c_bus);
+ #if CONFIG_OLED_DRIVER_ASYNC_FLUSH
+     // Let the last frame finish before the panel goes away
+     oled_flush_wait(driver, FLUSH_WAIT_MS);
+     if (driver->flush_task) {
+         vTaskDelete(driver->flush_task);
      }
-     if (driver->buffer) {
-         free(driver->buffer);
+ #endif
+     if (driver->panel) {
+         driver->panel->del(driver->panel);
      }
-     free(driver);
+     release_driver(driver);
  
      ESP_LOGI(TAG, "OLED driver deinitialized");
      return ESP_OK;
  }
  
+ oled_panel_t *oled_get_panel(oled_driver_t *driver) {
+     return driver ? driver->panel : NULL;
+ }
+ 
  esp_err_t oled_clear(oled_driver_t *driver) {
      if (!driver) {
          return ESP_ERR_INVALID_ARG;
      }
  
      memset(driver->buffer, 0, driver->width * driver->height / 8);
-     return oled_update(driver);
+     mark_dirty(driver, 0, 0, driver->width, driver->height);
+     return auto_update(driver);
  }
  
  esp_err_t oled_display_text(oled_driver_t *driver, const char *text, int x, int y, 
@@ -298,8 +348,29 @@
  
      int font_width = get_font_width(font);
      int font_height = get_font_height(font);
-     int text_width = strlen(text) * font_width;
-     
+     oled_rect_t box;
+     oled_text_box(text, x, y, font, align, &box);
+     x = box.x;
+ 
+     // Draw each character
+     int char_x = x;
+     for (int i = 0; text[i] != '\0'; i++) {
+         if (char_x >= 0 && char_x + font_width <= driver->width && 
+             y >= 0 && y + font_height <= driver->height) {
+             draw_char(driver, text[i], char_x, y, font);
+         }
+         char_x += font_width;
+     }
+     mark_dirty(driver, box.x, box.y, box.x + box.w, box.y + box.h);
+ 
+     return auto_update(driver);
+ }
+ 
+ void oled_text_box(const char *text, int x, int y, oled_font_t font, oled_align_t align, oled_rect_t *box) {
+     int font_width = get_font_width(font);
+     int len = text ? (int)strlen(text) : 0;
+     int text_width = len * font_width;
+ 
      // Adjust x position based on alignment
      switch (align) {
          case OLED_ALIGN_CENTER:
@@ -313,17 +384,11 @@
              break;
      }
  
-     // Draw each character
-     int char_x = x;
-     for (int i = 0; text[i] != '\0'; i++) {
-         if (char_x >= 0 && char_x + font_width <= driver->width && 
-             y >= 0 && y + font_height <= driver->height) {
-             draw_char(driver, text[i], char_x, y, font);
-         }
-         char_x += font_width;
-     }
- 
-     return oled_update(driver);
+     // Scaled glyphs reach past their advance, so the last one sets the right edge
+     box->x = x;
+     box->y = y;
+     box->w = len ? text_width - font_width + get_glyph_width(font) : 0;
+     box->h = len ? get_glyph_height(font) : 0;
  }
  
  esp_err_t oled_display_text_wrap(oled_driver_t *driver, const char *text, int x, int y, 
@@ -350,12 +415,14 @@
          if (current_x >= 0 && current_x + font_width <= driver->width && 
              current_y >= 0 && current_y + font_height <= driver->height) {
              draw_char(driver, text[i], current_x, current_y, font);
+             mark_dirty(driver, current_x, current_y, current_x + get_glyph_width(font),
+                        current_y + get_glyph_height(font));
          }
          current_x += font_width;
          line_width++;
      }
  
-     return oled_update(driver);
+     return auto_update(driver);
  }
  
  esp_err_t oled_draw_pixel(oled_driver_t *driver, int x, int y, int color) {
@@ -371,6 +438,7 @@
      } else {
          driver->buffer[byte_index] &= ~(1 << bit_index);
      }
+     mark_dirty(driver, x, y, x + 1, y + 1);
  
      return ESP_OK;
  }
@@ -380,6 +448,16 @@
          return ESP_ERR_INVALID_ARG;
      }
  
+     // Axis-aligned lines are spans
+     if (y1 == y2) {
+         fill_span(driver, MIN(x1, x2), y1, MAX(x1, x2) + 1, y1 + 1, color);
+         return ESP_OK;
+     }
+     if (x1 == x2) {
+         fill_span(driver, x1, MIN(y1, y2), x1 + 1, MAX(y1, y2) + 1, color);
+         return ESP_OK;
+     }
+ 
      int dx = abs(x2 - x1);
      int dy = abs(y2 - y1);
      int sx = (x1 < x2) ? 1 : -1;
@@ -410,12 +488,12 @@
          return ESP_ERR_INVALID_ARG;
      }
  
+     if (width <= 0 || height <= 0) {
+         return ESP_OK;
+     }
+ 
      if (filled) {
-         for (int i = 0; i < height; i++) {
-             for (int j = 0; j < width; j++) {
-                 oled_draw_pixel(driver, x + j, y + i, color);
-             }
-         }
+         fill_span(driver, x, y, x + width, y + height, color);
      } else {
          // Draw outline
          oled_draw_line(driver, x, y, x + width - 1, y, color);
@@ -427,12 +505,234 @@
      return ESP_OK;
  }
  
+ esp_err_t oled_draw_hline(oled_driver_t *driver, int x, int y, int width, int color) {
+     if (!driver || width < 0) {
+         return ESP_ERR_INVALID_ARG;
+     }
+ 
+     fill_span(driver, x, y, x + width, y + 1, color);
+     return ESP_OK;
+ }
+ 
+ esp_err_t oled_draw_vline(oled_driver_t *driver, int x, int y, int height, int color) {
+     if (!driver || height < 0) {
+         return ESP_ERR_INVALID_ARG;
+     }
+ 
+     fill_span(driver, x, y, x + 1, y + height, color);
+     return ESP_OK;
+ }
+ 
+ esp_err_t oled_clear_region(oled_driver_t *driver, int x, int y, int width, int height) {
+     if (!driver || width < 0 || height < 0) {
+         return ESP_ERR_INVALID_ARG;
+     }
+ 
+     fill_span(driver, x, y, x + width, y + height, 0);
+     return ESP_OK;
+ }
+ 
+ esp_err_t oled_scroll_left(oled_driver_t *driver, int x, int y, int width, int height, int n) {
+     if (!driver || width < 0 || height < 0 || n < 0) {
+         return ESP_ERR_INVALID_ARG;
+     }
+ 
+     int x0 = MAX(x, 0);
+     int y0 = MAX(y, 0);
+     int x1 = MIN(x + width, driver->width);
+     int y1 = MIN(y + height, driver->height);
+     if (x0 >= x1 || y0 >= y1 || n == 0) {
+         return ESP_OK;
+     }
+     if (n >= x1 - x0) {
+         fill_span(driver, x0, y0, x1, y1, 0);
+         return ESP_OK;
+     }
+ 
+     // Same page walk as fill_span: whole bytes move with memmove, partial pages merge under a mask
+     int keep = x1 - x0 - n;
+     for (int page = y0 >> 3; page <= (y1 - 1) >> 3; page++) {
+         int top = (page == (y0 >> 3)) ? (y0 & 7) : 0;
+         int bottom = (page == ((y1 - 1) >> 3)) ? ((y1 - 1) & 7) : 7;
+         uint8_t mask = (uint8_t)((0xFF << top) & (0xFF >> (7 - bottom)));
+         uint8_t *dst = driver->buffer + page * driver->width + x0;
+         if (mask == 0xFF) {
+             memmove(dst, dst + n, keep);
+             memset(dst + keep, 0, n);
+         } else {
+             for (int i = 0; i < keep; i++) {
+                 dst[i] = (uint8_t)((dst[i] & ~mask) | (dst[i + n] & mask));
+             }
+             for (int i = keep; i < keep + n; i++) {
+                 dst[i] &= (uint8_t)~mask;
+             }
+         }
+     }
+     mark_dirty(driver, x0, y0, x1, y1);
+     return ESP_OK;
+ }
+ 
+ // Send the windows listed in x0s/x1s from fb and mark them clean. One window per
+ // dirty page; consecutive full-width pages are contiguous in the framebuffer and go
+ // out as a single transfer. Windows that fail stay listed.
+ static esp_err_t send_windows(oled_driver_t *driver, const uint8_t *fb, int16_t *x0s, int16_t *x1s) {
+     esp_err_t ret = ESP_OK;
+     bool sent = false;
+     int page = 0;
+     while (page < driver->pages) {
+         int x0 = x0s[page];
+         int x1 = x1s[page];
+         if (x0 >= x1) {
+             page++;
+             continue;
+         }
+         int last = page;
+         if (x0 == 0 && x1 == driver->width) {
+             while (last + 1 < driver->pages && x0s[last + 1] == 0 && x1s[last + 1] == driver->width) {
+                 last++;
+             }
+         }
+         esp_err_t err = driver->panel->draw(driver->panel, x0, page * 8, x1, (last + 1) * 8,
+                                             fb + page * driver->width + x0);
+         if (err != ESP_OK) {
+             ret = err;
+             page = last + 1;
+             continue;
+         }
+         driver->stats.transfers++;
+         driver->stats.bytes += (uint32_t)(x1 - x0) * (last - page + 1);
+         sent = true;
+         for (int p = page; p <= last; p++) {
+             x0s[p] = 0;
+             x1s[p] = 0;
+         }
+         page = last + 1;
+     }
+     if (sent) {
+         driver->stats.flushes++;
+     }
+     return ret;
+ }
+ 
+ #if CONFIG_OLED_DRIVER_ASYNC_FLUSH
+ static void oled_flush_task(void *pvParameters) {
+     oled_driver_t *driver = (oled_driver_t *)pvParameters;
+     while (1) {
+         ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+         uint32_t flushes = driver->stats.flushes;
+         if (send_windows(driver, driver->front, driver->flush_x0, driver->flush_x1) != ESP_OK) {
+             // The back buffer may have moved on; resend everything with the next commit
+             driver->resend_all = true;
+         }
+         // Latency only for frames that reached the panel: latency_avg_us divides by flushes
+         if (driver->stats.flushes != flushes) {
+             uint32_t latency = (uint32_t)(esp_timer_get_time() - driver->commit_us);
+             driver->stats.latency_last_us = latency;
+             if (latency > driver->stats.latency_max_us) driver->stats.latency_max_us = latency;
+             driver->latency_sum_us += latency;
+         }
+         xSemaphoreGive(driver->flush_idle);
+     }
+ }
+ 
+ // Copy the dirty windows into the front buffer and hand them to the flush task
+ static esp_err_t commit_frame(oled_driver_t *driver) {
+     if (driver->resend_all) {
+         driver->resend_all = false;
+         mark_dirty(driver, 0, 0, driver->width, driver->height);
+     }
+     bool any = false;
+     for (int page = 0; page < driver->pages && !any; page++) {
+         any = driver->dirty_x0[page] < driver->dirty_x1[page];
+     }
+     if (!any) {
+         return ESP_OK;
+     }
+     if (xSemaphoreTake(driver->flush_idle, 0) != pdTRUE) {
+         // Previous frame still on the bus: the spans stay dirty and go out with the next commit
+         driver->stats.dropped++;
+         return ESP_OK;
+     }
+ 
+     for (int page = 0; page < driver->pages; page++) {
+         int x0 = driver->dirty_x0[page];
+         int x1 = driver->dirty_x1[page];
+         if (x0 < x1) {
+             int offset = page * driver->width + x0;
+             memcpy(driver->front + offset, driver->buffer + offset, x1 - x0);
+         }
+         driver->flush_x0[page] = x0;
+         driver->flush_x1[page] = x1;
+         driver->dirty_x0[page] = 0;
+         driver->dirty_x1[page] = 0;
+     }
+     driver->commit_us = esp_timer_get_time();
+     driver->stats.frames++;
+     xTaskNotifyGive(driver->flush_task);
+     return ESP_OK;
+ }
+ #endif
+ 
  esp_err_t oled_update(oled_driver_t *driver) {
      if (!driver) {
          return ESP_ERR_INVALID_ARG;
      }
+     if (driver->frame_depth > 0) {
+         return ESP_OK;
+     }
+ 
+ #if CONFIG_OLED_DRIVER_ASYNC_FLUSH
+     return commit_frame(driver);
+ #else
+     // Failed spans stay dirty so the next update retries them
+     return send_windows(driver, driver->buffer, driver->dirty_x0, driver->dirty_x1);
+ #endif
+ }
+ 
+ esp_err_t oled_flush_wait(oled_driver_t *driver, uint32_t timeout_ms) {
+     if (!driver) {
+         return ESP_ERR_INVALID_ARG;
+     }
+ 
+ #if CONFIG_OLED_DRIVER_ASYNC_FLUSH
+     if (xSemaphoreTake(driver->flush_idle, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+         return ESP_ERR_TIMEOUT;
+     }
+     xSemaphoreGive(driver->flush_idle);
+ #endif
+     return ESP_OK;
+ }
+ 
+ esp_err_t oled_begin_frame(oled_driver_t *driver) {
+     if (!driver) {
+         return ESP_ERR_INVALID_ARG;
+     }
  
-     return esp_lcd_panel_draw_bitmap(driver->panel_handle, 0, 0, driver->width, driver->height, driver->buffer);
+     driver->frame_depth++;
+     return ESP_OK;
+ }
+ 
+ esp_err_t oled_end_frame(oled_driver_t *driver) {
+     if (!driver || driver->frame_depth == 0) {
+         return ESP_ERR_INVALID_STATE;
+     }
+ 
+     driver->frame_depth--;
+     return driver->frame_depth == 0 ? oled_update(driver) : ESP_OK;
+ }
+ 
+ esp_err_t oled_get_stats(oled_driver_t *driver, oled_stats_t *stats) {
+     if (!driver || !stats) {
+         return ESP_ERR_INVALID_ARG;
+     }
+ 
+     *stats = driver->stats;
+ #if CONFIG_OLED_DRIVER_ASYNC_FLUSH
+     // frames counts commits; the last one may still be in flight
+     uint32_t done = stats->flushes;
+     stats->latency_avg_us = done ? (uint32_t)(driver->latency_sum_us / done) : 0;
+ #endif
+     return ESP_OK;
  }
  
  esp_err_t oled_set_brightness(oled_driver_t *driver, uint8_t brightness) {
@@ -450,8 +750,13 @@
          return ESP_ERR_INVALID_ARG;
      }
  
+     // Panel commands must not interleave with a window transfer
+     esp_err_t ret = oled_flush_wait(driver, FLUSH_WAIT_MS);
+     if (ret != ESP_OK) {
+         return ret;
+     }
      driver->inverted = invert;
-     return esp_lcd_panel_invert_color(driver->panel_handle, invert);
+     return driver->panel->invert(driver->panel, invert);
  }
  
  esp_err_t oled_rotate(oled_driver_t *driver, int rotation) {
@@ -459,7 +764,11 @@
          return ESP_ERR_INVALID_ARG;
      }
  
+     esp_err_t ret = oled_flush_wait(driver, FLUSH_WAIT_MS);
+     if (ret != ESP_OK) {
+         return ret;
+     }
      driver->rotation = rotation;
-     return esp_lcd_panel_swap_xy(driver->panel_handle, rotation == 90 || rotation == 270);
+     return driver->panel->swap_xy(driver->panel, rotation == 90 || rotation == 270);
  }
  
\ No newline at end of file
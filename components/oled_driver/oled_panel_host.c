@@ -0,0 +1,152 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "oled_panel_host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+
+static const char *TAG = "oled_host";
+
+typedef struct {
+    oled_panel_t base;
+    int width;
+    int height;
+    bool inverted;
+    bool swapped;          // Recorded only; images stay in framebuffer orientation
+    uint8_t *ram;          // Page-organised like the SSD1306 GDDRAM
+} host_panel_t;
+
+static esp_err_t host_draw(oled_panel_t *panel, int x0, int y0, int x1, int y1, const uint8_t *data) {
+    host_panel_t *p = (host_panel_t *)panel;
+    if (x0 < 0 || y0 < 0 || x1 > p->width || y1 > p->height || x0 >= x1 || (y0 & 7) || (y1 & 7)) {
+        ESP_LOGE(TAG, "Bad window [%d,%d)x[%d,%d)", x0, x1, y0, y1);
+        return ESP_ERR_INVALID_ARG;
+    }
+    int cols = x1 - x0;
+    for (int page = y0 / 8; page < y1 / 8; page++) {
+        memcpy(p->ram + page * p->width + x0, data, cols);
+        data += cols;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t host_invert(oled_panel_t *panel, bool invert) {
+    ((host_panel_t *)panel)->inverted = invert;
+    return ESP_OK;
+}
+
+static esp_err_t host_swap_xy(oled_panel_t *panel, bool swap) {
+    ((host_panel_t *)panel)->swapped = swap;
+    return ESP_OK;
+}
+
+static void host_del(oled_panel_t *panel) {
+    host_panel_t *p = (host_panel_t *)panel;
+    free(p->ram);
+    free(p);
+}
+
+esp_err_t oled_panel_new_host(int width, int height, oled_panel_t **panel) {
+    if (!panel || width <= 0 || height <= 0 || (height & 7)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host_panel_t *p = calloc(1, sizeof(host_panel_t));
+    if (!p) {
+        return ESP_ERR_NO_MEM;
+    }
+    p->ram = calloc(1, width * height / 8);
+    if (!p->ram) {
+        free(p);
+        return ESP_ERR_NO_MEM;
+    }
+    p->width = width;
+    p->height = height;
+    p->base.draw = host_draw;
+    p->base.invert = host_invert;
+    p->base.swap_xy = host_swap_xy;
+    p->base.del = host_del;
+    *panel = &p->base;
+    return ESP_OK;
+}
+
+bool oled_panel_host_get_pixel(const oled_panel_t *panel, int x, int y) {
+    const host_panel_t *p = (const host_panel_t *)panel;
+    if (x < 0 || y < 0 || x >= p->width || y >= p->height) {
+        return false;
+    }
+    bool lit = (p->ram[(y >> 3) * p->width + x] >> (y & 7)) & 1;
+    return lit != p->inverted;
+}
+
+// One PBM row: MSB first, 1 = black, so a lit OLED pixel is a 0 bit
+static void pack_row(const oled_panel_t *panel, int y, uint8_t *row, int row_bytes) {
+    memset(row, 0, row_bytes);
+    const host_panel_t *p = (const host_panel_t *)panel;
+    for (int x = 0; x < p->width; x++) {
+        if (!oled_panel_host_get_pixel(panel, x, y)) {
+            row[x >> 3] |= (uint8_t)(0x80 >> (x & 7));
+        }
+    }
+}
+
+esp_err_t oled_panel_host_write_pbm(const oled_panel_t *panel, const char *path) {
+    const host_panel_t *p = (const host_panel_t *)panel;
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Cannot write %s", path);
+        return ESP_FAIL;
+    }
+    int row_bytes = (p->width + 7) / 8;
+    uint8_t row[row_bytes];
+    fprintf(f, "P4\n%d %d\n", p->width, p->height);
+    for (int y = 0; y < p->height; y++) {
+        pack_row(panel, y, row, row_bytes);
+        fwrite(row, 1, row_bytes, f);
+    }
+    esp_err_t ret = ferror(f) ? ESP_FAIL : ESP_OK;
+    fclose(f);
+    return ret;
+}
+
+esp_err_t oled_panel_host_diff_pbm(const oled_panel_t *panel, const char *path, uint32_t *diff_pixels) {
+    const host_panel_t *p = (const host_panel_t *)panel;
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    int w = 0, h = 0;
+    // Header as written above: magic, size, then a single whitespace byte before the raster
+    if (fscanf(f, "P4 %d %d", &w, &h) != 2 || fgetc(f) == EOF) {
+        fclose(f);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (w != p->width || h != p->height) {
+        fclose(f);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    int row_bytes = (p->width + 7) / 8;
+    uint8_t want[row_bytes], have[row_bytes];
+    uint32_t diff = 0;
+    esp_err_t ret = ESP_OK;
+    for (int y = 0; y < p->height; y++) {
+        if (fread(want, 1, row_bytes, f) != (size_t)row_bytes) {
+            ret = ESP_ERR_INVALID_RESPONSE;
+            break;
+        }
+        pack_row(panel, y, have, row_bytes);
+        for (int x = 0; x < p->width; x++) {
+            uint8_t bit = (uint8_t)(0x80 >> (x & 7));
+            if ((want[x >> 3] ^ have[x >> 3]) & bit) {
+                diff++;
+            }
+        }
+    }
+    fclose(f);
+    *diff_pixels = diff;
+    return ret;
+}
@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "oled_driver.h"
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_vendor.h"
+#include "esp_lcd_panel_ssd1306.h"
+#include "driver/i2c_master.h"
+
+static const char *TAG = "oled_ssd1306";
+
+// SSD1306 over esp_lcd: page windows map 1:1 onto esp_lcd_panel_draw_bitmap()
+typedef struct {
+    oled_panel_t base;
+    i2c_master_bus_handle_t i2c_bus;
+    esp_lcd_panel_io_handle_t io_handle;
+    esp_lcd_panel_handle_t panel_handle;
+} ssd1306_panel_t;
+
+#if CONFIG_OLED_DRIVER_STATIC_ALLOC
+static ssd1306_panel_t s_static_panel;
+#endif
+
+static esp_err_t ssd1306_draw(oled_panel_t *panel, int x0, int y0, int x1, int y1, const uint8_t *data) {
+    ssd1306_panel_t *p = (ssd1306_panel_t *)panel;
+    return esp_lcd_panel_draw_bitmap(p->panel_handle, x0, y0, x1, y1, data);
+}
+
+static esp_err_t ssd1306_invert(oled_panel_t *panel, bool invert) {
+    ssd1306_panel_t *p = (ssd1306_panel_t *)panel;
+    return esp_lcd_panel_invert_color(p->panel_handle, invert);
+}
+
+static esp_err_t ssd1306_swap_xy(oled_panel_t *panel, bool swap) {
+    ssd1306_panel_t *p = (ssd1306_panel_t *)panel;
+    return esp_lcd_panel_swap_xy(p->panel_handle, swap);
+}
+
+static void ssd1306_del(oled_panel_t *panel) {
+    ssd1306_panel_t *p = (ssd1306_panel_t *)panel;
+    if (p->panel_handle) {
+        esp_lcd_panel_del(p->panel_handle);
+    }
+    if (p->io_handle) {
+        esp_lcd_panel_io_del(p->io_handle);
+    }
+    if (p->i2c_bus) {
+        i2c_del_master_bus(p->i2c_bus);
+    }
+#if !CONFIG_OLED_DRIVER_STATIC_ALLOC
+    free(p);
+#endif
+}
+
+esp_err_t oled_panel_new_ssd1306(const oled_config_t *config, oled_panel_t **panel) {
+    if (!config || !panel) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+#if CONFIG_OLED_DRIVER_STATIC_ALLOC
+    ssd1306_panel_t *p = &s_static_panel;
+    *p = (ssd1306_panel_t){ 0 };
+#else
+    ssd1306_panel_t *p = calloc(1, sizeof(ssd1306_panel_t));
+    if (!p) {
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+    p->base.draw = ssd1306_draw;
+    p->base.invert = ssd1306_invert;
+    p->base.swap_xy = ssd1306_swap_xy;
+    p->base.del = ssd1306_del;
+
+    // Initialize I2C bus
+    i2c_master_bus_config_t bus_config = {
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .i2c_port = 0,
+        .sda_io_num = config->sda_pin,
+        .scl_io_num = config->scl_pin,
+        .flags.enable_internal_pullup = true,
+    };
+    ESP_ERROR_CHECK(i2c_new_master_bus(&bus_config, &p->i2c_bus));
+
+    // Install panel IO
+    esp_lcd_panel_io_i2c_config_t io_config = {
+        .dev_addr = config->i2c_addr,
+        .scl_speed_hz = config->pixel_clock,
+        .control_phase_bytes = 1,
+        .lcd_cmd_bits = 8,
+        .lcd_param_bits = 8,
+        .dc_bit_offset = 6,
+    };
+    ESP_ERROR_CHECK(esp_lcd_new_panel_io_i2c(p->i2c_bus, &io_config, &p->io_handle));
+
+    // Install panel driver
+    esp_lcd_panel_dev_config_t panel_config = {
+        .bits_per_pixel = 1,
+        .reset_gpio_num = config->rst_pin,
+    };
+
+    esp_lcd_panel_ssd1306_config_t ssd1306_config = {
+        .height = config->height,
+    };
+    panel_config.vendor_config = &ssd1306_config;
+    ESP_ERROR_CHECK(esp_lcd_new_panel_ssd1306(p->io_handle, &panel_config, &p->panel_handle));
+
+    // Initialize panel
+    ESP_ERROR_CHECK(esp_lcd_panel_reset(p->panel_handle));
+    ESP_ERROR_CHECK(esp_lcd_panel_init(p->panel_handle));
+    ESP_ERROR_CHECK(esp_lcd_panel_mirror(p->panel_handle, true, true));
+    ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(p->panel_handle, true));
+
+    ESP_LOGD(TAG, "SSD1306 %dx%d at 0x%02x", config->width, config->height, config->i2c_addr);
+    *panel = &p->base;
+    return ESP_OK;
+}
@@ -0,0 +1,133 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "oled_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Retained-mode widgets on top of oled_driver.
+ *
+ * Each widget remembers what it last drew. A set call with an unchanged value
+ * returns false without touching the framebuffer, so no page goes dirty and the
+ * next oled_end_frame() sends nothing. When the value does change, only the
+ * widget's own box is redrawn. Widgets must not overlap.
+ *
+ * Widgets are plain structs owned by the caller (static storage is fine) and are
+ * drawn on the first set call after init.
+ */
+
+#define OLED_WIDGET_TEXT_MAX 32
+
+// Text at a fixed anchor; redrawn when the string changes
+typedef struct {
+    int x;
+    int y;
+    oled_font_t font;
+    oled_align_t align;
+    bool drawn;
+    oled_rect_t box;                    // Pixels covered by the current text
+    char text[OLED_WIDGET_TEXT_MAX];
+} oled_label_t;
+
+// Label showing one float through a printf format; redrawn when the formatted text changes
+typedef struct {
+    oled_label_t label;
+    const char *fmt;                    // One float conversion, e.g. "Distance: %.1f cm"
+    const char *invalid_text;           // Shown for invalid values
+} oled_numeric_t;
+
+// Horizontal bar gauge with a 1 px frame; only the columns that changed are filled or cleared
+typedef struct {
+    int x;
+    int y;
+    int w;
+    int h;
+    float min;
+    float max;
+    int fill;                           // Filled columns inside the frame, -1 before the first draw
+} oled_bar_t;
+
+// Scrolling line graph of the last w samples, scaled to [min, max]. Each push shifts
+// the box one column left and draws only the new right-hand column.
+typedef struct {
+    int x;
+    int y;
+    int w;
+    int h;
+    float min;
+    float max;
+    int prev_row;                       // Row of the previous sample, -1 after a gap
+    bool drawn;
+} oled_sparkline_t;
+
+/**
+ * @brief Initialise a label (nothing is drawn until the first oled_label_set())
+ */
+void oled_label_init(oled_label_t *label, int x, int y, oled_font_t font, oled_align_t align);
+
+/**
+ * @brief Show a new text; a no-op when it equals the current one
+ *
+ * @param driver Driver handle
+ * @param label Label
+ * @param text New text (truncated to OLED_WIDGET_TEXT_MAX - 1 characters)
+ * @return true if the label was redrawn
+ */
+bool oled_label_set(oled_driver_t *driver, oled_label_t *label, const char *text);
+
+/**
+ * @brief Initialise a numeric field
+ *
+ * @param fmt printf format with a single float conversion
+ * @param invalid_text Text shown when oled_numeric_set() gets valid = false
+ */
+void oled_numeric_init(oled_numeric_t *num, int x, int y, oled_font_t font, oled_align_t align,
+                       const char *fmt, const char *invalid_text);
+
+/**
+ * @brief Show a value; redraws only if the formatted text changed
+ *
+ * @return true if the field was redrawn
+ */
+bool oled_numeric_set(oled_driver_t *driver, oled_numeric_t *num, float value, bool valid);
+
+/**
+ * @brief Initialise a bar gauge covering [min, max]
+ */
+void oled_bar_init(oled_bar_t *bar, int x, int y, int w, int h, float min, float max);
+
+/**
+ * @brief Move the bar to a value (clamped); only the changed columns are drawn
+ *
+ * @return true if anything was drawn
+ */
+bool oled_bar_set(oled_driver_t *driver, oled_bar_t *bar, float value);
+
+/**
+ * @brief Initialise a sparkline
+ */
+void oled_sparkline_init(oled_sparkline_t *spark, int x, int y, int w, int h, float min, float max);
+
+/**
+ * @brief Append a sample: scroll one column and draw the new one (constant cost)
+ *
+ * @param driver Driver handle
+ * @param spark Sparkline
+ * @param value Sample value
+ * @param valid false leaves an empty column (gap in the line)
+ * @return true (the graph always changes)
+ */
+bool oled_sparkline_push(oled_driver_t *driver, oled_sparkline_t *spark, float value, bool valid);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "oled_widgets.h"
+#include <stdio.h>
+#include <string.h>
+
+void oled_label_init(oled_label_t *label, int x, int y, oled_font_t font, oled_align_t align)
+{
+    memset(label, 0, sizeof(*label));
+    label->x = x;
+    label->y = y;
+    label->font = font;
+    label->align = align;
+}
+
+bool oled_label_set(oled_driver_t *driver, oled_label_t *label, const char *text)
+{
+    if (label->drawn && strncmp(label->text, text, sizeof(label->text) - 1) == 0) {
+        return false;
+    }
+
+    // Erase the old text, then draw the new one; only these two boxes go dirty
+    if (label->box.w > 0) {
+        oled_clear_region(driver, label->box.x, label->box.y, label->box.w, label->box.h);
+    }
+    strlcpy(label->text, text, sizeof(label->text));
+    oled_display_text(driver, label->text, label->x, label->y, label->font, label->align);
+    oled_text_box(label->text, label->x, label->y, label->font, label->align, &label->box);
+    label->drawn = true;
+    return true;
+}
+
+void oled_numeric_init(oled_numeric_t *num, int x, int y, oled_font_t font, oled_align_t align,
+                       const char *fmt, const char *invalid_text)
+{
+    oled_label_init(&num->label, x, y, font, align);
+    num->fmt = fmt;
+    num->invalid_text = invalid_text;
+}
+
+bool oled_numeric_set(oled_driver_t *driver, oled_numeric_t *num, float value, bool valid)
+{
+    if (!valid) {
+        return oled_label_set(driver, &num->label, num->invalid_text);
+    }
+    char text[OLED_WIDGET_TEXT_MAX];
+    snprintf(text, sizeof(text), num->fmt, value);
+    return oled_label_set(driver, &num->label, text);
+}
+
+void oled_bar_init(oled_bar_t *bar, int x, int y, int w, int h, float min, float max)
+{
+    bar->x = x;
+    bar->y = y;
+    bar->w = w;
+    bar->h = h;
+    bar->min = min;
+    bar->max = max;
+    bar->fill = -1;
+}
+
+bool oled_bar_set(oled_driver_t *driver, oled_bar_t *bar, float value)
+{
+    int inner = bar->w - 2;
+    float span = bar->max - bar->min;
+    int fill = span > 0 ? (int)((value - bar->min) * inner / span + 0.5f) : 0;
+    if (fill < 0) fill = 0;
+    if (fill > inner) fill = inner;
+    if (fill == bar->fill) {
+        return false;
+    }
+
+    if (bar->fill < 0) {
+        oled_clear_region(driver, bar->x, bar->y, bar->w, bar->h);
+        oled_draw_rectangle(driver, bar->x, bar->y, bar->w, bar->h, 0, 1);
+        bar->fill = 0;
+    }
+    // Only the columns between the old and the new end change
+    int ix = bar->x + 1;
+    if (fill > bar->fill) {
+        oled_draw_rectangle(driver, ix + bar->fill, bar->y + 1, fill - bar->fill, bar->h - 2, 1, 1);
+    } else if (fill < bar->fill) {
+        oled_clear_region(driver, ix + fill, bar->y + 1, bar->fill - fill, bar->h - 2);
+    }
+    bar->fill = fill;
+    return true;
+}
+
+void oled_sparkline_init(oled_sparkline_t *spark, int x, int y, int w, int h, float min, float max)
+{
+    memset(spark, 0, sizeof(*spark));
+    spark->x = x;
+    spark->y = y;
+    spark->w = w;
+    spark->h = h;
+    spark->min = min;
+    spark->max = max;
+    spark->prev_row = -1;
+}
+
+// Row of a value inside the box (0 = top)
+static int sparkline_row(const oled_sparkline_t *spark, float value)
+{
+    float span = spark->max - spark->min;
+    int row = span > 0 ? (int)((spark->max - value) * (spark->h - 1) / span + 0.5f) : spark->h - 1;
+    if (row < 0) row = 0;
+    if (row > spark->h - 1) row = spark->h - 1;
+    return row;
+}
+
+bool oled_sparkline_push(oled_driver_t *driver, oled_sparkline_t *spark, float value, bool valid)
+{
+    if (!spark->drawn) {
+        oled_clear_region(driver, spark->x, spark->y, spark->w, spark->h);
+        spark->drawn = true;
+    }
+
+    // Oldest sample leaves on the left, the newest column is drawn at the right edge
+    oled_scroll_left(driver, spark->x, spark->y, spark->w, spark->h, 1);
+    if (!valid) {
+        spark->prev_row = -1;
+        return true;
+    }
+    int row = sparkline_row(spark, value);
+    // Vertical segment from the previous point keeps steep changes connected
+    int top = (spark->prev_row < 0 || row < spark->prev_row) ? row : spark->prev_row;
+    int bottom = (spark->prev_row < 0 || row > spark->prev_row) ? row : spark->prev_row;
+    oled_draw_vline(driver, spark->x + spark->w - 1, spark->y + top, bottom - top + 1, 1);
+    spark->prev_row = row;
+    return true;
+}
@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sample_ring.h"
+#include "sample_pb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Batch of consecutive samples, the payload of the uplinks: a smart_embed.Batch
+ * protobuf message (proto/smart_embed.proto).
+ *
+ * Samples are varint-encoded into the two packed columns as they arrive, inside the
+ * caller's buffer; sample_batch_finish() writes the header fields in front and
+ * closes the gap, so the finished message needs no second buffer. Samples of one
+ * batch have consecutive sequence numbers, so only the first is sent; a gap in
+ * the stream starts a new batch. (boot_id, batch_seq) identifies a batch across
+ * reboots and lets receivers drop the duplicates of at-least-once delivery.
+ */
+
+#define SAMPLE_BATCH_MAX_SAMPLES    255
+// Room for the header fields and the first column's tag and length
+#define SAMPLE_BATCH_HEAD_BYTES     40
+// Each column value is clamped to 21 bits: at most 3 varint bytes
+#define SAMPLE_BATCH_COLUMN_BYTES(n) (3 * (n))
+
+// Buffer size for a batch of up to n samples, and the largest message it produces
+#define SAMPLE_BATCH_BYTES(n) (SAMPLE_BATCH_HEAD_BYTES + 2 * SAMPLE_BATCH_COLUMN_BYTES(n))
+
+// Batch being filled
+typedef struct {
+    uint8_t *buf;           // SAMPLE_BATCH_BYTES(max_samples) bytes, owned by the caller
+    uint8_t max_samples;
+    uint8_t count;
+    uint16_t dt_len;        // Encoded bytes in the dt_ms column
+    uint16_t mm_len;        // Encoded bytes in the distance_mm column
+    uint32_t first_seq;
+    uint32_t last_seq;
+    int64_t first_t_us;
+    int64_t last_t_us;
+} sample_batch_t;
+
+/**
+ * @brief Start an empty batch in a caller-owned buffer
+ *
+ * @param batch Batch to initialise
+ * @param buf Buffer of at least SAMPLE_BATCH_BYTES(max_samples) bytes
+ * @param max_samples Size threshold (1..SAMPLE_BATCH_MAX_SAMPLES)
+ */
+void sample_batch_init(sample_batch_t *batch, uint8_t *buf, uint8_t max_samples);
+
+/**
+ * @brief Append a sample
+ *
+ * @param batch Batch
+ * @param item Sample from the sample ring
+ * @return false if the batch is full or @p item does not follow the last sample;
+ *         finish the batch, reset it and add the sample again
+ */
+bool sample_batch_add(sample_batch_t *batch, const sample_ring_item_t *item);
+
+/**
+ * @brief Complete the message in batch->buf and return its length
+ *
+ * @param batch Batch with at least one sample
+ * @param boot_id Random per-boot identifier
+ * @param batch_seq Batch number within this boot
+ * @return size_t Bytes of batch->buf to send (0 for an empty batch)
+ */
+size_t sample_batch_finish(sample_batch_t *batch, uint16_t boot_id, uint32_t batch_seq);
+
+/**
+ * @brief Empty the batch, keeping its buffer and size threshold
+ */
+void sample_batch_reset(sample_batch_t *batch);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sample_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Protobuf encoding of the messages in proto/smart_embed.proto.
+ *
+ * Every serialised sample (HTTP, MQTT, UDP, exports) goes through this file and
+ * sample_batch.c. The messages are flat and bounded, so they are written straight
+ * into the caller's buffer: no generated descriptors, no allocation, no pointer
+ * arrays for repeated fields.
+ */
+
+#define SAMPLE_PB_SCHEMA_VERSION    1
+
+// Largest encoded Sample (every field at its maximum varint length)
+#define SAMPLE_PB_SAMPLE_MAX_BYTES  38
+// Largest encoded Rollup
+#define SAMPLE_PB_ROLLUP_MAX_BYTES  68
+// Largest encoded Histogram with n bins (packed varints of at most 5 bytes)
+#define SAMPLE_PB_HISTOGRAM_MAX_BYTES(n) (48 + 5 * (n))
+// Varint length prefix in front of each message of a stream (writeDelimitedTo)
+#define SAMPLE_PB_DELIMITER_MAX_BYTES 5
+
+// Window summary, see message Rollup
+typedef struct {
+    uint32_t window_s;
+    int64_t end_ms;
+    uint32_t count;
+    uint32_t valid;
+    float min_cm;
+    float max_cm;
+    float mean_cm;
+    float stddev_cm;
+    float p50_cm;
+    float p95_cm;
+    float p99_cm;
+} sample_rollup_t;
+
+// Histogram header, see message Histogram; the bins are passed separately
+typedef struct {
+    uint32_t window_s;
+    int64_t start_ms;
+    uint32_t bin_mm;
+    uint32_t samples;
+    uint32_t invalid;
+} sample_pb_histogram_t;
+
+// Tracker fields of a live Sample
+typedef struct {
+    int32_t velocity_mm_s;
+    uint32_t ttc_ms;
+    bool alert;
+} sample_pb_motion_t;
+
+// Wire types used by the schema
+enum {
+    PB_WIRE_VARINT = 0,
+    PB_WIRE_LEN = 2,
+    PB_WIRE_FIXED32 = 5,
+};
+
+/**
+ * @brief Bytes taken by @p v as a varint
+ */
+size_t pb_varint_size(uint64_t v);
+
+/**
+ * @brief Write a varint, return the position after it
+ */
+uint8_t *pb_put_varint(uint8_t *p, uint64_t v);
+
+/**
+ * @brief Write a tag (field number and wire type), return the position after it
+ */
+uint8_t *pb_put_tag(uint8_t *p, uint32_t field, uint32_t wire_type);
+
+/**
+ * @brief Write an integer field; proto3 leaves zero values out
+ */
+uint8_t *pb_put_uint(uint8_t *p, uint32_t field, uint64_t v);
+
+/**
+ * @brief Write a signed (sint32, zigzag) field; proto3 leaves zero values out
+ */
+uint8_t *pb_put_sint(uint8_t *p, uint32_t field, int32_t v);
+
+/**
+ * @brief Write a float field (fixed32); proto3 leaves 0.0 out
+ */
+uint8_t *pb_put_float(uint8_t *p, uint32_t field, float v);
+
+/**
+ * @brief Distance as carried on the wire: millimetres, 0 for an invalid reading
+ */
+uint32_t sample_pb_distance_mm(const sample_ring_item_t *item);
+
+/**
+ * @brief Encode a Sample message
+ *
+ * @param item Reading
+ * @param motion Tracker estimate, or NULL to leave those fields out
+ * @param buf Output, at least SAMPLE_PB_SAMPLE_MAX_BYTES
+ * @param len Size of @p buf
+ * @return size_t Bytes written, 0 if @p buf is too small
+ */
+size_t sample_pb_encode_sample(const sample_ring_item_t *item, const sample_pb_motion_t *motion,
+                               uint8_t *buf, size_t len);
+
+/**
+ * @brief Encode a Rollup message
+ *
+ * @param rollup Window summary
+ * @param buf Output, at least SAMPLE_PB_ROLLUP_MAX_BYTES
+ * @param len Size of @p buf
+ * @return size_t Bytes written, 0 if @p buf is too small
+ */
+size_t sample_pb_encode_rollup(const sample_rollup_t *rollup, uint8_t *buf, size_t len);
+
+/**
+ * @brief Encode a Histogram message
+ *
+ * @param hist Window and counters
+ * @param bins Bin counts
+ * @param nbins Number of bins
+ * @param buf Output, at least SAMPLE_PB_HISTOGRAM_MAX_BYTES(nbins)
+ * @param len Size of @p buf
+ * @return size_t Bytes written, 0 if @p buf is too small
+ */
+size_t sample_pb_encode_histogram(const sample_pb_histogram_t *hist, const uint32_t *bins, size_t nbins,
+                                  uint8_t *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
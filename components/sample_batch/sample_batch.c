@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "sample_batch.h"
+#include <string.h>
+
+#define COLUMN_MAX 0x1FFFFF     // Largest value that fits 3 varint bytes
+
+static uint8_t *dt_column(const sample_batch_t *batch)
+{
+    return batch->buf + SAMPLE_BATCH_HEAD_BYTES;
+}
+
+static uint8_t *mm_column(const sample_batch_t *batch)
+{
+    return batch->buf + SAMPLE_BATCH_HEAD_BYTES + SAMPLE_BATCH_COLUMN_BYTES(batch->max_samples);
+}
+
+void sample_batch_init(sample_batch_t *batch, uint8_t *buf, uint8_t max_samples)
+{
+    batch->buf = buf;
+    batch->max_samples = max_samples ? max_samples : 1;
+    sample_batch_reset(batch);
+}
+
+void sample_batch_reset(sample_batch_t *batch)
+{
+    batch->count = 0;
+    batch->dt_len = 0;
+    batch->mm_len = 0;
+    batch->first_seq = 0;
+    batch->last_seq = 0;
+    batch->first_t_us = 0;
+    batch->last_t_us = 0;
+}
+
+bool sample_batch_add(sample_batch_t *batch, const sample_ring_item_t *item)
+{
+    if (batch->count >= batch->max_samples) {
+        return false;
+    }
+    uint32_t dt_ms = 0;
+    if (batch->count == 0) {
+        batch->first_seq = item->seq;
+        batch->first_t_us = item->t_us;
+    } else {
+        if (item->seq != batch->last_seq + 1) {
+            return false;
+        }
+        int64_t dt = (item->t_us - batch->last_t_us) / 1000;
+        dt_ms = dt < 0 ? 0 : (dt > COLUMN_MAX ? COLUMN_MAX : (uint32_t)dt);
+    }
+    uint32_t mm = sample_pb_distance_mm(item);
+    if (mm > COLUMN_MAX) {
+        mm = COLUMN_MAX;
+    }
+
+    batch->dt_len = (uint16_t)(pb_put_varint(dt_column(batch) + batch->dt_len, dt_ms) - dt_column(batch));
+    batch->mm_len = (uint16_t)(pb_put_varint(mm_column(batch) + batch->mm_len, mm) - mm_column(batch));
+    batch->count++;
+    batch->last_seq = item->seq;
+    batch->last_t_us = item->t_us;
+    return true;
+}
+
+size_t sample_batch_finish(sample_batch_t *batch, uint16_t boot_id, uint32_t batch_seq)
+{
+    if (batch->count == 0) {
+        return 0;
+    }
+    // Header fields end at most 32 bytes in, below the dt column at SAMPLE_BATCH_HEAD_BYTES;
+    // each column then moves down to just after the previous part (never overlapping upwards)
+    uint8_t *p = batch->buf;
+    p = pb_put_uint(p, 1, SAMPLE_PB_SCHEMA_VERSION);
+    p = pb_put_uint(p, 2, boot_id);
+    p = pb_put_uint(p, 3, batch_seq);
+    p = pb_put_uint(p, 4, batch->first_seq);
+    p = pb_put_uint(p, 5, batch->first_t_us > 0 ? (uint64_t)(batch->first_t_us / 1000) : 0);
+
+    p = pb_put_tag(p, 6, PB_WIRE_LEN);
+    p = pb_put_varint(p, batch->dt_len);
+    memmove(p, dt_column(batch), batch->dt_len);
+    p += batch->dt_len;
+
+    p = pb_put_tag(p, 7, PB_WIRE_LEN);
+    p = pb_put_varint(p, batch->mm_len);
+    memmove(p, mm_column(batch), batch->mm_len);
+    p += batch->mm_len;
+    return (size_t)(p - batch->buf);
+}
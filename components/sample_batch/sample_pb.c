@@ -0,0 +1,136 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "sample_pb.h"
+#include <string.h>
+
+size_t pb_varint_size(uint64_t v)
+{
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+uint8_t *pb_put_varint(uint8_t *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+uint8_t *pb_put_tag(uint8_t *p, uint32_t field, uint32_t wire_type)
+{
+    return pb_put_varint(p, (field << 3) | wire_type);
+}
+
+uint8_t *pb_put_uint(uint8_t *p, uint32_t field, uint64_t v)
+{
+    if (v == 0) {
+        return p;
+    }
+    p = pb_put_tag(p, field, PB_WIRE_VARINT);
+    return pb_put_varint(p, v);
+}
+
+uint8_t *pb_put_sint(uint8_t *p, uint32_t field, int32_t v)
+{
+    return pb_put_uint(p, field, ((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+uint8_t *pb_put_float(uint8_t *p, uint32_t field, float v)
+{
+    if (v == 0.0f) {
+        return p;
+    }
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    p = pb_put_tag(p, field, PB_WIRE_FIXED32);
+    p[0] = (uint8_t)bits;
+    p[1] = (uint8_t)(bits >> 8);
+    p[2] = (uint8_t)(bits >> 16);
+    p[3] = (uint8_t)(bits >> 24);
+    return p + 4;
+}
+
+uint32_t sample_pb_distance_mm(const sample_ring_item_t *item)
+{
+    if (!item->valid || item->distance <= 0.0f) {
+        return 0;
+    }
+    uint32_t mm = (uint32_t)(item->distance * 10.0f + 0.5f);
+    return mm ? mm : 1;
+}
+
+size_t sample_pb_encode_sample(const sample_ring_item_t *item, const sample_pb_motion_t *motion,
+                               uint8_t *buf, size_t len)
+{
+    if (len < SAMPLE_PB_SAMPLE_MAX_BYTES) {
+        return 0;
+    }
+    uint8_t *p = buf;
+    p = pb_put_uint(p, 1, item->seq);
+    p = pb_put_uint(p, 2, item->t_us > 0 ? (uint64_t)(item->t_us / 1000) : 0);
+    p = pb_put_uint(p, 3, sample_pb_distance_mm(item));
+    if (motion) {
+        p = pb_put_sint(p, 4, motion->velocity_mm_s);
+        p = pb_put_uint(p, 5, motion->ttc_ms);
+        p = pb_put_uint(p, 6, motion->alert);
+    }
+    return (size_t)(p - buf);
+}
+
+size_t sample_pb_encode_rollup(const sample_rollup_t *rollup, uint8_t *buf, size_t len)
+{
+    if (len < SAMPLE_PB_ROLLUP_MAX_BYTES) {
+        return 0;
+    }
+    uint8_t *p = buf;
+    p = pb_put_uint(p, 1, SAMPLE_PB_SCHEMA_VERSION);
+    p = pb_put_uint(p, 2, rollup->window_s);
+    p = pb_put_uint(p, 3, rollup->end_ms > 0 ? (uint64_t)rollup->end_ms : 0);
+    p = pb_put_uint(p, 4, rollup->count);
+    p = pb_put_uint(p, 5, rollup->valid);
+    p = pb_put_float(p, 6, rollup->min_cm);
+    p = pb_put_float(p, 7, rollup->max_cm);
+    p = pb_put_float(p, 8, rollup->mean_cm);
+    p = pb_put_float(p, 9, rollup->stddev_cm);
+    p = pb_put_float(p, 10, rollup->p50_cm);
+    p = pb_put_float(p, 11, rollup->p95_cm);
+    p = pb_put_float(p, 12, rollup->p99_cm);
+    return (size_t)(p - buf);
+}
+
+size_t sample_pb_encode_histogram(const sample_pb_histogram_t *hist, const uint32_t *bins, size_t nbins,
+                                  uint8_t *buf, size_t len)
+{
+    if (len < SAMPLE_PB_HISTOGRAM_MAX_BYTES(nbins)) {
+        return 0;
+    }
+    uint8_t *p = buf;
+    p = pb_put_uint(p, 1, SAMPLE_PB_SCHEMA_VERSION);
+    p = pb_put_uint(p, 2, hist->window_s);
+    p = pb_put_uint(p, 3, hist->start_ms > 0 ? (uint64_t)hist->start_ms : 0);
+    p = pb_put_uint(p, 4, hist->bin_mm);
+    p = pb_put_uint(p, 5, hist->samples);
+    p = pb_put_uint(p, 6, hist->invalid);
+
+    // Packed field: the length prefix needs the encoded size first
+    size_t packed = 0;
+    for (size_t i = 0; i < nbins; i++) {
+        packed += pb_varint_size(bins[i]);
+    }
+    p = pb_put_tag(p, 7, PB_WIRE_LEN);
+    p = pb_put_varint(p, packed);
+    for (size_t i = 0; i < nbins; i++) {
+        p = pb_put_varint(p, bins[i]);
+    }
+    return (size_t)(p - buf);
+}
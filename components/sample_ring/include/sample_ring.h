@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Single-producer sample stream.
+ *
+ * sensor_task appends each reading once; any number of readers follow it with a
+ * private cursor and never consume samples for each other (unlike a queue).
+ */
+
+// One sensor reading
+typedef struct {
+    uint32_t seq;           // Sample sequence number (same as sample_trace)
+    int64_t t_us;           // TRIG pulse time, esp_timer clock
+    float distance;         // cm, only meaningful when valid
+    bool valid;             // In sensor range
+} sample_ring_item_t;
+
+// Reader position
+typedef struct {
+    uint32_t next;          // Sequence index of the next item to read
+    uint32_t dropped;       // Items overwritten before this reader got to them
+} sample_ring_cursor_t;
+
+// Static RAM taken by the ring
+#define SAMPLE_RING_RAM_BYTES (CONFIG_SAMPLE_RING_SIZE * sizeof(sample_ring_item_t))
+
+/**
+ * @brief Append a reading (sensor_task only)
+ *
+ * @param item Reading to copy into the ring
+ */
+void sample_ring_push(const sample_ring_item_t *item);
+
+/**
+ * @brief Position a cursor so that at most @p backlog existing items are read
+ *
+ * @param cursor Cursor to initialise
+ * @param backlog Number of most recent items to include (0 = only new ones)
+ */
+void sample_ring_cursor_init(sample_ring_cursor_t *cursor, size_t backlog);
+
+/**
+ * @brief Copy the next item for this reader
+ *
+ * @param cursor Reader cursor
+ * @param out Item copy
+ * @return true if an item was returned, false if the reader is caught up
+ */
+bool sample_ring_read(sample_ring_cursor_t *cursor, sample_ring_item_t *out);
+
+/**
+ * @brief Copy the most recent item
+ *
+ * @return false if nothing was pushed yet
+ */
+bool sample_ring_latest(sample_ring_item_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "sample_ring.h"
+#include "freertos/FreeRTOS.h"
+
+#define RING_SIZE CONFIG_SAMPLE_RING_SIZE
+#define RING_MASK (RING_SIZE - 1)
+
+_Static_assert((RING_SIZE & RING_MASK) == 0, "CONFIG_SAMPLE_RING_SIZE must be a power of two");
+
+static sample_ring_item_t s_ring[RING_SIZE];
+static uint32_t s_head;     // Items pushed so far
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void sample_ring_push(const sample_ring_item_t *item)
+{
+    // A 24-byte copy: short enough for a critical section, and readers never see a torn item
+    portENTER_CRITICAL(&s_lock);
+    s_ring[s_head & RING_MASK] = *item;
+    s_head++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void sample_ring_cursor_init(sample_ring_cursor_t *cursor, size_t backlog)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint32_t head = s_head;
+    portEXIT_CRITICAL(&s_lock);
+    if (backlog > RING_SIZE) backlog = RING_SIZE;
+    cursor->next = (head > backlog) ? head - (uint32_t)backlog : 0;
+    cursor->dropped = 0;
+}
+
+bool sample_ring_read(sample_ring_cursor_t *cursor, sample_ring_item_t *out)
+{
+    bool ok = false;
+    portENTER_CRITICAL(&s_lock);
+    if (s_head - cursor->next > RING_SIZE) {
+        // Lapped by the producer: skip to the oldest item still in the ring
+        cursor->dropped += s_head - RING_SIZE - cursor->next;
+        cursor->next = s_head - RING_SIZE;
+    }
+    if (cursor->next != s_head) {
+        *out = s_ring[cursor->next & RING_MASK];
+        cursor->next++;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return ok;
+}
+
+bool sample_ring_latest(sample_ring_item_t *out)
+{
+    bool ok = false;
+    portENTER_CRITICAL(&s_lock);
+    if (s_head > 0) {
+        *out = s_ring[(s_head - 1) & RING_MASK];
+        ok = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return ok;
+}
@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sample_ring.h"
+#include "sample_pb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Streaming distance statistics over sliding windows (1 min, 1 h, 24 h).
+ *
+ * Each window is a ring of time buckets holding Welford count/mean/M2 and min/max;
+ * a query merges the live buckets (Chan et al.), so the window slides by one bucket
+ * and covers between (N-1)/N and all of its length. Quantiles come from P² estimators
+ * (five markers each, no stored samples). P² cannot forget old samples, so every
+ * window runs two of them restarted half a window apart and reports the older one,
+ * which has seen between half and all of the window.
+ *
+ * sample_stats_add() is O(1) with constant memory; only valid readings enter the
+ * distance figures, every reading counts towards `count`.
+ */
+
+typedef enum {
+    SAMPLE_STATS_1MIN,
+    SAMPLE_STATS_1H,
+    SAMPLE_STATS_24H,
+    SAMPLE_STATS_WINDOWS
+} sample_stats_window_t;
+
+// Static RAM taken by the buckets and estimators of all windows
+#define SAMPLE_STATS_RAM_BYTES 3700
+
+/**
+ * @brief Create the lock; call once before the first sample_stats_add()
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t sample_stats_init(void);
+
+/**
+ * @brief Feed one reading into every window
+ *
+ * @param item Sample from the sample ring (its t_us places it in time)
+ */
+void sample_stats_add(const sample_ring_item_t *item);
+
+/**
+ * @brief Summarise one window as of now
+ *
+ * Distance fields are 0 when the window holds no valid reading.
+ *
+ * @param window Window
+ * @param out Summary (Rollup message of smart_embed.proto)
+ * @return esp_err_t ESP_ERR_INVALID_ARG for an unknown window, ESP_ERR_INVALID_STATE before init
+ */
+esp_err_t sample_stats_get(sample_stats_window_t window, sample_rollup_t *out);
+
+/**
+ * @brief Short window name ("1m", "1h", "24h") as used in GET /stats
+ */
+const char *sample_stats_window_name(sample_stats_window_t window);
+
+#ifdef __cplusplus
+}
+#endif
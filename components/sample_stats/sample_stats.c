@@ -0,0 +1,276 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "sample_stats.h"
+#include <string.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+#define MAX_BUCKETS     30
+#define QUANTILES       3
+#define P2_MARKERS      5
+
+static const float s_quantiles[QUANTILES] = { 0.50f, 0.95f, 0.99f };
+
+// Window length = buckets x bucket_s
+static const struct {
+    const char *name;
+    uint32_t bucket_s;
+    uint8_t buckets;
+} s_layout[SAMPLE_STATS_WINDOWS] = {
+    [SAMPLE_STATS_1MIN] = { "1m",  5,    12 },
+    [SAMPLE_STATS_1H]   = { "1h",  120,  30 },
+    [SAMPLE_STATS_24H]  = { "24h", 3600, 24 },
+};
+
+// Welford accumulator of one time bucket
+typedef struct {
+    uint32_t epoch;         // t / bucket_s of the samples it holds
+    uint32_t count;
+    uint32_t valid;
+    float mean;
+    float m2;
+    float min;
+    float max;
+} bucket_t;
+
+// P² quantile estimator (Jain & Chlamtac 1985)
+typedef struct {
+    uint32_t count;
+    float q[P2_MARKERS];    // Marker heights; the first five samples until count reaches 5
+    int32_t n[P2_MARKERS];  // Actual marker positions
+    float np[P2_MARKERS];   // Desired marker positions
+} p2_t;
+
+typedef struct {
+    bucket_t bucket[MAX_BUCKETS];
+    p2_t p2[2][QUANTILES];  // Two generations, restarted half a window apart
+    uint32_t half;          // t / (window / 2) at the last sample
+    bool started;
+} window_t;
+
+static window_t s_windows[SAMPLE_STATS_WINDOWS];
+static SemaphoreHandle_t s_lock;
+static StaticSemaphore_t s_lock_buf;
+
+_Static_assert(sizeof(s_windows) <= SAMPLE_STATS_RAM_BYTES, "SAMPLE_STATS_RAM_BYTES out of date");
+
+static void p2_reset(p2_t *p, float quantile)
+{
+    p->count = 0;
+    for (int i = 0; i < P2_MARKERS; i++) {
+        p->n[i] = i;
+    }
+    p->np[0] = 0.0f;
+    p->np[1] = 2.0f * quantile;
+    p->np[2] = 4.0f * quantile;
+    p->np[3] = 2.0f + 2.0f * quantile;
+    p->np[4] = 4.0f;
+}
+
+static float p2_parabolic(const p2_t *p, int i, int d)
+{
+    float span = (float)(p->n[i + 1] - p->n[i - 1]);
+    float up = (float)(p->n[i] - p->n[i - 1] + d) * (p->q[i + 1] - p->q[i]) / (float)(p->n[i + 1] - p->n[i]);
+    float down = (float)(p->n[i + 1] - p->n[i] - d) * (p->q[i] - p->q[i - 1]) / (float)(p->n[i] - p->n[i - 1]);
+    return p->q[i] + (float)d / span * (up + down);
+}
+
+static void p2_add(p2_t *p, float quantile, float x)
+{
+    if (p->count < P2_MARKERS) {
+        // Insertion sort of the first five samples
+        int i = (int)p->count++;
+        while (i > 0 && p->q[i - 1] > x) {
+            p->q[i] = p->q[i - 1];
+            i--;
+        }
+        p->q[i] = x;
+        return;
+    }
+
+    int k;
+    if (x < p->q[0]) {
+        p->q[0] = x;
+        k = 0;
+    } else if (x >= p->q[4]) {
+        p->q[4] = x;
+        k = 3;
+    } else {
+        k = 0;
+        while (x >= p->q[k + 1]) {
+            k++;
+        }
+    }
+    for (int i = k + 1; i < P2_MARKERS; i++) {
+        p->n[i]++;
+    }
+    p->np[1] += quantile / 2.0f;
+    p->np[2] += quantile;
+    p->np[3] += (1.0f + quantile) / 2.0f;
+    p->np[4] += 1.0f;
+
+    for (int i = 1; i <= 3; i++) {
+        float delta = p->np[i] - (float)p->n[i];
+        if ((delta >= 1.0f && p->n[i + 1] - p->n[i] > 1) || (delta <= -1.0f && p->n[i - 1] - p->n[i] < -1)) {
+            int d = delta > 0 ? 1 : -1;
+            float q = p2_parabolic(p, i, d);
+            if (!(p->q[i - 1] < q && q < p->q[i + 1])) {
+                // Parabola overshoots a neighbour: linear step instead
+                q = p->q[i] + (float)d * (p->q[i + d] - p->q[i]) / (float)(p->n[i + d] - p->n[i]);
+            }
+            p->q[i] = q;
+            p->n[i] += d;
+        }
+    }
+    p->count++;
+}
+
+static float p2_get(const p2_t *p, float quantile)
+{
+    if (p->count == 0) {
+        return 0.0f;
+    }
+    if (p->count < P2_MARKERS) {
+        // Too few for markers: nearest rank in the sorted samples
+        return p->q[(int)(quantile * (float)(p->count - 1) + 0.5f)];
+    }
+    return p->q[2];
+}
+
+esp_err_t sample_stats_init(void)
+{
+    s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+    return s_lock ? ESP_OK : ESP_FAIL;
+}
+
+static void window_add(sample_stats_window_t w, const sample_ring_item_t *item, uint32_t t_s)
+{
+    window_t *win = &s_windows[w];
+    uint32_t epoch = t_s / s_layout[w].bucket_s;
+    bucket_t *b = &win->bucket[epoch % s_layout[w].buckets];
+    if (b->epoch != epoch || b->count == 0) {
+        *b = (bucket_t){ .epoch = epoch };
+    }
+    b->count++;
+
+    // Restart the P² generation whose turn it is; one that missed a whole window restarts too
+    uint32_t half_s = s_layout[w].bucket_s * s_layout[w].buckets / 2;
+    uint32_t half = t_s / half_s;
+    if (!win->started || half != win->half) {
+        for (int g = 0; g < 2; g++) {
+            if (!win->started || (uint32_t)g == half % 2 || half - win->half >= 2) {
+                for (int q = 0; q < QUANTILES; q++) {
+                    p2_reset(&win->p2[g][q], s_quantiles[q]);
+                }
+            }
+        }
+        win->half = half;
+        win->started = true;
+    }
+
+    if (!item->valid) {
+        return;
+    }
+    float x = item->distance;
+    b->valid++;
+    if (b->valid == 1) {
+        b->min = b->max = x;
+    } else {
+        b->min = fminf(b->min, x);
+        b->max = fmaxf(b->max, x);
+    }
+    float delta = x - b->mean;
+    b->mean += delta / (float)b->valid;
+    b->m2 += delta * (x - b->mean);
+
+    for (int g = 0; g < 2; g++) {
+        for (int q = 0; q < QUANTILES; q++) {
+            p2_add(&win->p2[g][q], s_quantiles[q], x);
+        }
+    }
+}
+
+void sample_stats_add(const sample_ring_item_t *item)
+{
+    if (!s_lock) {
+        return;
+    }
+    uint32_t t_s = (uint32_t)(item->t_us / 1000000);
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int w = 0; w < SAMPLE_STATS_WINDOWS; w++) {
+        window_add((sample_stats_window_t)w, item, t_s);
+    }
+    xSemaphoreGive(s_lock);
+}
+
+esp_err_t sample_stats_get(sample_stats_window_t window, sample_rollup_t *out)
+{
+    if ((unsigned)window >= SAMPLE_STATS_WINDOWS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t now_us = esp_timer_get_time();
+    uint32_t now_s = (uint32_t)(now_us / 1000000);
+    uint32_t now_epoch = now_s / s_layout[window].bucket_s;
+    uint32_t half_s = s_layout[window].bucket_s * s_layout[window].buckets / 2;
+    const window_t *win = &s_windows[window];
+
+    *out = (sample_rollup_t){
+        .window_s = s_layout[window].bucket_s * s_layout[window].buckets,
+        .end_ms = now_us / 1000,
+    };
+    // Merge in double: float M2 sums over a day of samples would lose the variance
+    double mean = 0.0, m2 = 0.0;
+    uint32_t valid = 0;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < s_layout[window].buckets; i++) {
+        const bucket_t *b = &win->bucket[i];
+        if (b->count == 0 || now_epoch - b->epoch >= s_layout[window].buckets) {
+            continue;
+        }
+        out->count += b->count;
+        if (b->valid == 0) {
+            continue;
+        }
+        if (valid == 0 || b->min < out->min_cm) out->min_cm = b->min;
+        if (valid == 0 || b->max > out->max_cm) out->max_cm = b->max;
+        uint32_t n = valid + b->valid;
+        double delta = (double)b->mean - mean;
+        mean += delta * b->valid / n;
+        m2 += (double)b->m2 + delta * delta * (double)valid * b->valid / n;
+        valid = n;
+    }
+
+    // Older generation first; nothing if the window has seen no sample for a whole window
+    uint32_t now_half = now_s / half_s;
+    if (win->started && now_half - win->half < 2) {
+        const p2_t *older = win->p2[(win->half + 1) % 2];
+        const p2_t *younger = win->p2[win->half % 2];
+        const p2_t *p = older[0].count >= younger[0].count ? older : younger;
+        out->p50_cm = p2_get(&p[0], s_quantiles[0]);
+        out->p95_cm = p2_get(&p[1], s_quantiles[1]);
+        out->p99_cm = p2_get(&p[2], s_quantiles[2]);
+    }
+    xSemaphoreGive(s_lock);
+
+    out->valid = valid;
+    out->mean_cm = (float)mean;
+    out->stddev_cm = valid > 1 ? (float)sqrt(m2 / (valid - 1)) : 0.0f;
+    return ESP_OK;
+}
+
+const char *sample_stats_window_name(sample_stats_window_t window)
+{
+    if ((unsigned)window >= SAMPLE_STATS_WINDOWS) {
+        return "?";
+    }
+    return s_layout[window].name;
+}
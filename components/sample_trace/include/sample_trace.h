@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per-sample latency tracing.
+ *
+ * sensor_task opens a trace for every sample with its sequence number and TRIG
+ * timestamp. Each pipeline stage then calls sample_trace_mark() once it has
+ * handled that sample; the latency since the trigger is added to the stage's
+ * log2 histogram. Only the first mark of a stage per sample counts, so stages
+ * that look at the same sample repeatedly (LED poll, HTTP polling) record the
+ * time at which the sample first became visible there.
+ */
+
+// Pipeline stages, in the order a sample normally passes them
+typedef enum {
+    SAMPLE_STAGE_FILTER,        // Range check done in sensor_task
+    SAMPLE_STAGE_SNAPSHOT,      // Published to g_distance / g_distance_seq
+    SAMPLE_STAGE_LED,           // LED decision taken on it
+    SAMPLE_STAGE_SD_STAGED,     // Received by sdcard_task
+    SAMPLE_STAGE_SD_FLUSHED,    // Committed (written and fsync'ed) on the SD card; rows parked in flash are not marked
+    SAMPLE_STAGE_HTTP_EMIT,     // First sent to an HTTP client
+    SAMPLE_STAGE_MAX
+} sample_stage_t;
+
+// Samples in flight; must cover the slowest stage (SD flush) at the sample rate. Marks for
+// older samples are counted as stale
+#define SAMPLE_TRACE_WINDOW 16
+
+// Histogram bucket i counts latencies in [2^i, 2^(i+1)) us; bucket 0 also holds 0 us
+#define SAMPLE_TRACE_BUCKETS 24
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[SAMPLE_TRACE_BUCKETS];
+} sample_trace_hist_t;
+
+typedef struct {
+    sample_trace_hist_t stage[SAMPLE_STAGE_MAX];
+    uint32_t samples;       // Traces opened
+    uint32_t stale_marks;   // Marks for samples already evicted from the trace window
+} sample_trace_stats_t;
+
+/**
+ * @brief Open the trace of a new sample
+ *
+ * @param seq Sample sequence number
+ * @param t_trigger_us esp_timer time of the TRIG pulse
+ */
+void sample_trace_begin(uint32_t seq, int64_t t_trigger_us);
+
+/**
+ * @brief Record that a stage has handled a sample
+ *
+ * Cheap enough for every loop iteration: repeated marks for the same sample
+ * and stage return after a table lookup.
+ *
+ * @param seq Sample sequence number
+ * @param stage Pipeline stage
+ */
+void sample_trace_mark(uint32_t seq, sample_stage_t stage);
+
+/**
+ * @brief Copy the current histograms
+ *
+ * @param out Destination
+ */
+void sample_trace_get_stats(sample_trace_stats_t *out);
+
+/**
+ * @brief Clear all histograms and counters
+ */
+void sample_trace_reset(void);
+
+/**
+ * @brief Approximate percentile from a histogram (upper bound of the bucket)
+ *
+ * @param hist Histogram
+ * @param pct Percentile, 0..100
+ * @return uint32_t Latency in microseconds
+ */
+uint32_t sample_trace_percentile(const sample_trace_hist_t *hist, float pct);
+
+/**
+ * @brief Stage name used in JSON and console output
+ */
+const char *sample_trace_stage_name(sample_stage_t stage);
+
+/**
+ * @brief Print one summary line per stage to the console
+ */
+void sample_trace_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
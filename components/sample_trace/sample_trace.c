@@ -0,0 +1,141 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "sample_trace.h"
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "sample_trace";
+
+#define TRACE_WINDOW SAMPLE_TRACE_WINDOW
+
+typedef struct {
+    uint32_t seq;
+    int64_t t_trigger_us;
+    uint32_t marked;        // Bit per stage already recorded
+    bool open;
+} trace_entry_t;
+
+static trace_entry_t s_window[TRACE_WINDOW];
+static sample_trace_stats_t s_stats;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const s_stage_names[SAMPLE_STAGE_MAX] = {
+    [SAMPLE_STAGE_FILTER]     = "filter",
+    [SAMPLE_STAGE_SNAPSHOT]   = "snapshot",
+    [SAMPLE_STAGE_LED]        = "led",
+    [SAMPLE_STAGE_SD_STAGED]  = "sd_staged",
+    [SAMPLE_STAGE_SD_FLUSHED] = "sd_flushed",
+    [SAMPLE_STAGE_HTTP_EMIT]  = "http_emit",
+};
+
+static inline int bucket_of(uint32_t us)
+{
+    if (us == 0) return 0;
+    int b = 31 - __builtin_clz(us);
+    return (b < SAMPLE_TRACE_BUCKETS) ? b : SAMPLE_TRACE_BUCKETS - 1;
+}
+
+void sample_trace_begin(uint32_t seq, int64_t t_trigger_us)
+{
+    trace_entry_t *e = &s_window[seq % TRACE_WINDOW];
+    portENTER_CRITICAL(&s_lock);
+    e->seq = seq;
+    e->t_trigger_us = t_trigger_us;
+    e->marked = 0;
+    e->open = true;
+    s_stats.samples++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void sample_trace_mark(uint32_t seq, sample_stage_t stage)
+{
+    if ((unsigned)stage >= SAMPLE_STAGE_MAX) {
+        return;
+    }
+    trace_entry_t *e = &s_window[seq % TRACE_WINDOW];
+    uint32_t bit = 1u << stage;
+
+    // Fast path for the polling stages: already recorded, nothing to do
+    if (e->seq == seq && (e->marked & bit)) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    if (!e->open || e->seq != seq) {
+        s_stats.stale_marks++;
+    } else if (!(e->marked & bit)) {
+        e->marked |= bit;
+        int64_t dt = now - e->t_trigger_us;
+        uint32_t us = (dt < 0) ? 0 : (dt > UINT32_MAX) ? UINT32_MAX : (uint32_t)dt;
+        sample_trace_hist_t *h = &s_stats.stage[stage];
+        h->count++;
+        h->sum_us += us;
+        if (us > h->max_us) h->max_us = us;
+        h->buckets[bucket_of(us)]++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void sample_trace_get_stats(sample_trace_stats_t *out)
+{
+    portENTER_CRITICAL(&s_lock);
+    memcpy(out, &s_stats, sizeof(*out));
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void sample_trace_reset(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    memset(&s_stats, 0, sizeof(s_stats));
+    portEXIT_CRITICAL(&s_lock);
+}
+
+uint32_t sample_trace_percentile(const sample_trace_hist_t *hist, float pct)
+{
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)((pct / 100.0f) * (float)hist->count + 0.5f);
+    if (rank == 0) rank = 1;
+    uint32_t seen = 0;
+    for (int i = 0; i < SAMPLE_TRACE_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint32_t upper = (i == SAMPLE_TRACE_BUCKETS - 1) ? hist->max_us : (2u << i);
+            return (upper < hist->max_us) ? upper : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+const char *sample_trace_stage_name(sample_stage_t stage)
+{
+    if ((unsigned)stage >= SAMPLE_STAGE_MAX) {
+        return "?";
+    }
+    return s_stage_names[stage];
+}
+
+void sample_trace_dump(void)
+{
+    // Large struct: keep it off the caller's stack
+    static sample_trace_stats_t stats;
+    sample_trace_get_stats(&stats);
+
+    ESP_LOGI(TAG, "%" PRIu32 " samples traced, %" PRIu32 " stale marks",
+             stats.samples, stats.stale_marks);
+    for (int i = 0; i < SAMPLE_STAGE_MAX; i++) {
+        const sample_trace_hist_t *h = &stats.stage[i];
+        ESP_LOGI(TAG, "%-10s n=%-6" PRIu32 " mean=%" PRIu32 "us p50<=%" PRIu32 "us p99<=%" PRIu32 "us max=%" PRIu32 "us",
+                 s_stage_names[i], h->count,
+                 h->count ? (uint32_t)(h->sum_us / h->count) : 0,
+                 sample_trace_percentile(h, 50), sample_trace_percentile(h, 99), h->max_us);
+    }
+}
@@ -1,6 +1,35 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 
+// FAT mount point; sensor.csv and events.csv live here (written through log_store)
+#define SDCARD_MOUNT_POINT "/sdcard"
+
+// Card health; times in ms
+typedef struct {
+    uint32_t outages;           // Card lost while mounted (no reply or repeated write errors)
+    uint32_t remounts;          // Mounts that ended an outage (a card missing at boot included)
+    uint32_t mount_failures;    // Mount attempts that failed
+    uint32_t io_errors;         // Failed card writes reported by log_store
+    uint32_t outage_ms;         // Current outage so far, 0 while mounted
+    uint32_t last_outage_ms;    // Last ended outage: lost to mounted again
+    uint32_t max_outage_ms;
+    uint32_t retry_in_ms;       // Until the next mount attempt, 0 while mounted
+    uint8_t backoff_level;      // Consecutive failed mount attempts (capped)
+    bool mounted;
+} sdcard_metrics_t;
+
+// Mount the card and put log_store online (or offline on failure); writer task only
 bool sdcard_init(void);
-bool sdcard_save_sensor_data(float distance, long long timestamp);
\ No newline at end of file
+// Writer task, once per loop after the commits: after a failed write, check the card
+// and unmount it when gone; while unmounted, try to mount again with exponential backoff
+// (1 s to CONFIG_SMART_EMBED_SD_REMOUNT_MAX_S). Never blocks otherwise
+void sdcard_service(void);
+// Copy the health counters (any task)
+void sdcard_get_metrics(sdcard_metrics_t *out);
+// Queue one row for sensor.csv; log_store_commit() writes it to the card
+bool sdcard_save_sensor_data(float distance, long long timestamp);
+// Queue one occupancy event for events.csv: seq,type,t_ms,dwell_ms,distance_mm
+bool sdcard_save_event(unsigned long seq, const char *type, unsigned long t_ms, unsigned long dwell_ms,
+                       unsigned distance_mm);
\ No newline at end of file
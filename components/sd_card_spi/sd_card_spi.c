@@ -8,11 +8,16 @@
    CONDITIONS OF ANY KIND, either express or implied.
 */
 #include <sd_card_spi.h>
+#include <stdio.h>
 #include <string.h>
 #include <sys/unistd.h>
 #include <sys/stat.h>
+#include <sys/param.h>
 #include "esp_vfs_fat.h"
 #include "sdmmc_cmd.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "log_store.h"
 #include "sd_test_io.h"
 #if SOC_SDMMC_IO_POWER_EXTERNAL
 #include "sd_pwr_ctrl_by_on_chip_ldo.h"
@@ -22,7 +27,7 @@
 
 static const char *TAG = "example";
 
-#define MOUNT_POINT "/sdcard"
+#define MOUNT_POINT SDCARD_MOUNT_POINT
 
 #ifdef CONFIG_EXAMPLE_DEBUG_PIN_CONNECTIONS
 const char* names[] = {"CLK ", "MOSI", "MISO", "CS  "};
@@ -55,6 +60,18 @@ pin_configuration_t config = {
 #define PIN_NUM_CLK   CONFIG_EXAMPLE_PIN_CLK
 #define PIN_NUM_CS    CONFIG_EXAMPLE_PIN_CS
 
+#define REMOUNT_MIN_MS  1000
+
+// Card state, changed by the writer task only (sdcard_init/sdcard_service)
+static sdmmc_card_t *s_card;
+static bool s_mounted;
+static int s_backoff_level;
+static int64_t s_outage_us;         // Card lost or missing at boot (0 while mounted)
+static int64_t s_next_mount_us;
+static uint32_t s_seen_errors;      // log_store_card_errors() at the last check
+static sdcard_metrics_t s_metrics;
+static portMUX_TYPE s_metrics_lock = portMUX_INITIALIZER_UNLOCKED;
+
 static esp_err_t s_example_write_file(const char *path, char *data)
 {
     ESP_LOGI(TAG, "Opening file %s", path);
@@ -91,7 +108,7 @@ static esp_err_t s_example_read_file(const char *path)
 
     return ESP_OK;
 }
-bool sdcard_init(void)
+static bool mount_card(void)
 {
     esp_err_t ret;
 
@@ -148,8 +165,9 @@ bool sdcard_init(void)
         .max_transfer_sz = 4000,
     };
 
+    // Bus đã có từ lần mount trước (sdcard_init được gọi lại khi thẻ vắng): dùng tiếp
     ret = spi_bus_initialize(host.slot, &bus_cfg, SDSPI_DEFAULT_DMA);
-    if (ret != ESP_OK) {
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
         ESP_LOGE(TAG, "Failed to initialize bus.");
         return false;
     }
@@ -177,20 +195,139 @@ bool sdcard_init(void)
         return false;
     }
     ESP_LOGI(TAG, "Filesystem mounted");
+    s_card = card;
 
     return true; // Nếu thành công
     // Card has been initialized, print its properties
     // sdmmc_card_print_info(stdout, card);
 };
+// REMOUNT_MIN_MS * 2^(level - 1), capped at CONFIG_SMART_EMBED_SD_REMOUNT_MAX_S
+static uint32_t backoff_ms(int level)
+{
+    uint32_t delay = REMOUNT_MIN_MS;
+    for (int i = 1; i < level && delay < CONFIG_SMART_EMBED_SD_REMOUNT_MAX_S * 1000; i++) {
+        delay *= 2;
+    }
+    return MIN(delay, CONFIG_SMART_EMBED_SD_REMOUNT_MAX_S * 1000);
+}
+
+bool sdcard_init(void)
+{
+    bool ok = mount_card();
+    int64_t now = esp_timer_get_time();
+    bool was_out = s_outage_us != 0;
+    uint32_t outage_ms = was_out ? (uint32_t)((now - s_outage_us) / 1000) : 0;
+    if (ok) {
+        s_backoff_level = 0;
+        s_seen_errors = 0;
+    } else if (s_backoff_level < 16) {
+        s_backoff_level++;
+    }
+    // Times under the lock too: sdcard_get_metrics() reads them from the HTTP task
+    portENTER_CRITICAL(&s_metrics_lock);
+    if (ok) {
+        if (was_out) {
+            s_metrics.remounts++;
+            s_metrics.last_outage_ms = outage_ms;
+            s_metrics.max_outage_ms = MAX(s_metrics.max_outage_ms, outage_ms);
+        }
+        s_outage_us = 0;
+    } else {
+        s_metrics.mount_failures++;
+        if (!was_out) {
+            s_outage_us = now;
+        }
+        s_next_mount_us = now + (int64_t)backoff_ms(s_backoff_level) * 1000;
+    }
+    s_metrics.backoff_level = (uint8_t)s_backoff_level;
+    s_metrics.mounted = ok;
+    portEXIT_CRITICAL(&s_metrics_lock);
+
+    if (ok && was_out) {
+        ESP_LOGI(TAG, "SD card back after %lu ms", (unsigned long)outage_ms);
+    }
+    s_mounted = ok;
+    // Không có thẻ: log_store ghi vào bản dự phòng (flash), không thử fopen trên /sdcard
+    log_store_set_online(ok);
+    return ok;
+}
+
+static void card_lost(int64_t now, const char *why)
+{
+    ESP_LOGW(TAG, "SD card lost (%s), buffering until it is back", why);
+    // Files closed before the volume goes; the unmount of a pulled card only frees memory
+    log_store_set_online(false);
+    log_store_fat_lock();
+    esp_vfs_fat_sdcard_unmount(MOUNT_POINT, s_card);
+    log_store_fat_unlock();
+    s_card = NULL;
+    s_mounted = false;
+    s_backoff_level = 0;
+    portENTER_CRITICAL(&s_metrics_lock);
+    s_outage_us = now;
+    s_next_mount_us = now + REMOUNT_MIN_MS * 1000;
+    s_metrics.outages++;
+    s_metrics.backoff_level = 0;
+    s_metrics.mounted = false;
+    portEXIT_CRITICAL(&s_metrics_lock);
+}
+
+void sdcard_service(void)
+{
+    int64_t now = esp_timer_get_time();
+    if (s_mounted) {
+        uint32_t errors = log_store_card_errors();
+        if (errors == s_seen_errors) {
+            return;
+        }
+        uint32_t fresh = errors > s_seen_errors ? errors - s_seen_errors : errors;
+        s_seen_errors = errors;
+        if (fresh == 0) {
+            return;     // A good write reset the count
+        }
+        portENTER_CRITICAL(&s_metrics_lock);
+        s_metrics.io_errors += fresh;
+        portEXIT_CRITICAL(&s_metrics_lock);
+        // Chỉ hỏi thẻ (CMD13) sau khi ghi lỗi: thẻ đã rút không trả lời, thẻ chập chờn được thử thêm
+        if (errors >= CONFIG_SMART_EMBED_SD_MAX_ERRORS) {
+            card_lost(now, "repeated write errors");
+        } else if (sdmmc_get_status(s_card) != ESP_OK) {
+            card_lost(now, "no reply");
+        }
+        return;
+    }
+    if (now >= s_next_mount_us) {
+        sdcard_init();
+    }
+}
+
+void sdcard_get_metrics(sdcard_metrics_t *out)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_metrics_lock);
+    *out = s_metrics;
+    int64_t outage_us = s_outage_us;
+    int64_t next_us = s_next_mount_us;
+    portEXIT_CRITICAL(&s_metrics_lock);
+    out->outage_ms = outage_us ? (uint32_t)((now - outage_us) / 1000) : 0;
+    out->retry_in_ms = !out->mounted && next_us > now ? (uint32_t)((next_us - now) / 1000) : 0;
+}
+
 bool sdcard_save_sensor_data(float distance, long long timestamp)
 {
-    char path[64];
-    snprintf(path, sizeof(path), "%s/sensor.csv", MOUNT_POINT);
-    FILE *f = fopen(path, "a"); // <== dùng "w" để ghi đè, a để ghi tiếp
-    if (!f) return false;
-    fprintf(f, "%.2f,%lld\n", distance, timestamp);
-    fclose(f);
-    return true;
+    // Không mở file mỗi mẫu: dòng vào RAM tail của log_store, sdcard_task commit theo lô.
+    // Giữ CSV trên thẻ (không phải Batch): /export cắt segment/Range theo byte của file, dòng bị
+    // cắt dở được nhận ra nhờ '\n', và thẻ đọc được trên PC. Dạng protobuf: /sensor/history?format=pb
+    char row[40];
+    int n = snprintf(row, sizeof(row), "%.2f,%lld\n", distance, timestamp);
+    return log_store_append(LOG_STORE_SENSOR, row, n) == ESP_OK;
+}
+bool sdcard_save_event(unsigned long seq, const char *type, unsigned long t_ms, unsigned long dwell_ms,
+                       unsigned distance_mm)
+{
+    char row[80];
+    int n = snprintf(row, sizeof(row), "%lu,%s,%lu,%lu,%u\n", seq, type, t_ms, dwell_ms, distance_mm);
+    return log_store_append(LOG_STORE_EVENTS, row, n) == ESP_OK;
 }
 // void app_main(void)
 // {
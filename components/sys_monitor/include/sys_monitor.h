@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SYS_MONITOR_TASK_NAME_LEN 16
+
+// One task as seen over the current window
+typedef struct {
+    char name[SYS_MONITOR_TASK_NAME_LEN];
+    uint8_t priority;
+    uint8_t state;              // eTaskState
+    uint16_t cpu_permille;      // Share of the window, 0..1000 (0xFFFF = run-time stats disabled)
+    uint32_t stack_hwm;         // Minimum free stack ever, in bytes
+} sys_monitor_task_t;
+
+// Heap figures for the default 8-bit capable heap
+typedef struct {
+    uint32_t free;              // heap_caps_get_free_size()
+    uint32_t min_free;          // Lowest free size since boot
+    uint32_t largest_block;     // Largest allocatable block
+    uint8_t frag_pct;           // 100 - largest_block * 100 / free
+} sys_monitor_heap_t;
+
+typedef struct {
+    uint32_t uptime_ms;
+    uint32_t window_ms;         // Time span the CPU figures cover
+    uint8_t task_count;
+    sys_monitor_task_t tasks[CONFIG_SYS_MONITOR_MAX_TASKS];
+    sys_monitor_heap_t heap;
+} sys_monitor_report_t;
+
+/**
+ * @brief Start sysmon_task (run-time counter sampling and the periodic log line)
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t sys_monitor_init(void);
+
+/**
+ * @brief Copy the latest report (tasks sorted by CPU share, highest first)
+ *
+ * @param out Destination
+ * @return esp_err_t ESP_ERR_INVALID_STATE before the first window is complete
+ */
+esp_err_t sys_monitor_get_report(sys_monitor_report_t *out);
+
+/**
+ * @brief Read current heap figures (no sampling needed)
+ *
+ * @param out Destination
+ */
+void sys_monitor_get_heap(sys_monitor_heap_t *out);
+
+/**
+ * @brief Print the compact status line now
+ */
+void sys_monitor_log_line(void);
+
+#ifdef __cplusplus
+}
+#endif
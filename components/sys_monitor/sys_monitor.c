@@ -0,0 +1,213 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "sys_monitor.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "sys_monitor";
+
+#define MAX_TASKS       CONFIG_SYS_MONITOR_MAX_TASKS
+#define WINDOW          CONFIG_SYS_MONITOR_WINDOW_SAMPLES
+
+// Run-time counters of every task at one sample instant
+typedef struct {
+    uint32_t total;
+    uint8_t count;
+    struct {
+        TaskHandle_t handle;
+        uint32_t counter;
+    } task[MAX_TASKS];
+} counter_snapshot_t;
+
+// WINDOW + 1 snapshots bound WINDOW sample periods
+static counter_snapshot_t s_snapshots[WINDOW + 1];
+static int s_snap_head = 0;     // Next slot to write
+static int s_snap_count = 0;
+
+static TaskStatus_t s_status[MAX_TASKS];
+static sys_monitor_report_t s_report;
+static bool s_report_valid = false;
+static SemaphoreHandle_t s_report_mutex = NULL;
+static StaticSemaphore_t s_report_mutex_buf;
+static StackType_t s_task_stack[CONFIG_SYS_MONITOR_TASK_STACK_SIZE];
+static StaticTask_t s_task_tcb;
+
+void sys_monitor_get_heap(sys_monitor_heap_t *out)
+{
+    out->free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    out->min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    out->largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    out->frag_pct = out->free ? (uint8_t)(100 - (uint64_t)out->largest_block * 100 / out->free) : 0;
+}
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+// Counter of a task in an older snapshot; false for tasks created since then
+static bool find_counter(const counter_snapshot_t *snap, TaskHandle_t handle, uint32_t *counter)
+{
+    for (int i = 0; i < snap->count; i++) {
+        if (snap->task[i].handle == handle) {
+            *counter = snap->task[i].counter;
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+static void sample_once(void)
+{
+    uint32_t total = 0;
+    UBaseType_t n = uxTaskGetSystemState(s_status, MAX_TASKS, &total);
+    if (n == 0) {
+        // More tasks than MAX_TASKS: the kernel refuses to fill a short array
+        ESP_LOGW(TAG, "More than %d tasks, raise CONFIG_SYS_MONITOR_MAX_TASKS", MAX_TASKS);
+        return;
+    }
+
+    counter_snapshot_t *now = &s_snapshots[s_snap_head];
+    now->total = total;
+    now->count = (uint8_t)n;
+    for (UBaseType_t i = 0; i < n; i++) {
+        now->task[i].handle = s_status[i].xHandle;
+        now->task[i].counter = s_status[i].ulRunTimeCounter;
+    }
+    s_snap_head = (s_snap_head + 1) % (WINDOW + 1);
+    if (s_snap_count < WINDOW + 1) s_snap_count++;
+    if (s_snap_count < 2) {
+        return;
+    }
+
+    // Oldest snapshot still in the ring
+    int oldest_idx = (s_snap_count < WINDOW + 1) ? 0 : s_snap_head;
+    const counter_snapshot_t *old = &s_snapshots[oldest_idx];
+    uint32_t total_delta = now->total - old->total;   // Wraps safely (u32 counters)
+
+    static sys_monitor_report_t next;
+    memset(&next, 0, sizeof(next));
+    next.uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    next.window_ms = (uint32_t)(s_snap_count - 1) * CONFIG_SYS_MONITOR_SAMPLE_MS;
+    next.task_count = (uint8_t)n;
+
+    for (UBaseType_t i = 0; i < n; i++) {
+        sys_monitor_task_t *t = &next.tasks[i];
+        strlcpy(t->name, s_status[i].pcTaskName, sizeof(t->name));
+        t->priority = (uint8_t)s_status[i].uxCurrentPriority;
+        t->state = (uint8_t)s_status[i].eCurrentState;
+        // ESP-IDF StackType_t is a byte, so the high-water mark is already in bytes
+        t->stack_hwm = s_status[i].usStackHighWaterMark;
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        // A task created during the window (httpd on GOT_IP, the MQTT client) has no start
+        // counter: its lifetime counter is not a window delta, report 0 until it has one
+        uint32_t before;
+        if (total_delta && find_counter(old, s_status[i].xHandle, &before)) {
+            uint32_t delta = s_status[i].ulRunTimeCounter - before;
+            t->cpu_permille = (uint16_t)MIN((uint64_t)delta * 1000 / total_delta, 1000);
+        } else {
+            t->cpu_permille = 0;
+        }
+#else
+        t->cpu_permille = 0xFFFF;
+#endif
+    }
+
+    // Highest CPU share first (insertion sort, n is small)
+    for (int i = 1; i < next.task_count; i++) {
+        sys_monitor_task_t key = next.tasks[i];
+        int j = i - 1;
+        while (j >= 0 && next.tasks[j].cpu_permille < key.cpu_permille) {
+            next.tasks[j + 1] = next.tasks[j];
+            j--;
+        }
+        next.tasks[j + 1] = key;
+    }
+
+    sys_monitor_get_heap(&next.heap);
+
+    xSemaphoreTake(s_report_mutex, portMAX_DELAY);
+    memcpy(&s_report, &next, sizeof(s_report));
+    s_report_valid = true;
+    xSemaphoreGive(s_report_mutex);
+}
+
+esp_err_t sys_monitor_get_report(sys_monitor_report_t *out)
+{
+    if (!s_report_mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_report_mutex, portMAX_DELAY);
+    bool valid = s_report_valid;
+    if (valid) {
+        memcpy(out, &s_report, sizeof(*out));
+    }
+    xSemaphoreGive(s_report_mutex);
+    return valid ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+void sys_monitor_log_line(void)
+{
+    static sys_monitor_report_t report;
+    static char line[512];
+    if (sys_monitor_get_report(&report) != ESP_OK) {
+        return;
+    }
+
+    // "cpu/stack" per task, then heap: one line instead of a block per subsystem
+    int pos = snprintf(line, sizeof(line), "%" PRIu32 "s |", report.window_ms / 1000);
+    for (int i = 0; i < report.task_count && pos < (int)sizeof(line) - 48; i++) {
+        const sys_monitor_task_t *t = &report.tasks[i];
+        if (t->cpu_permille == 0xFFFF) {
+            pos += snprintf(line + pos, sizeof(line) - pos, " %s:-/%" PRIu32, t->name, t->stack_hwm);
+        } else {
+            pos += snprintf(line + pos, sizeof(line) - pos, " %s:%u.%u%%/%" PRIu32, t->name,
+                            t->cpu_permille / 10, t->cpu_permille % 10, t->stack_hwm);
+        }
+    }
+    snprintf(line + pos, sizeof(line) - pos,
+             " | heap %" PRIu32 " min %" PRIu32 " lfb %" PRIu32 " frag %u%%",
+             report.heap.free, report.heap.min_free, report.heap.largest_block, report.heap.frag_pct);
+    ESP_LOGI(TAG, "%s", line);
+}
+
+static void sysmon_task(void *pvParameters)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t since_log_ms = 0;
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(CONFIG_SYS_MONITOR_SAMPLE_MS));
+        sample_once();
+#if CONFIG_SYS_MONITOR_LOG_PERIOD_S > 0
+        since_log_ms += CONFIG_SYS_MONITOR_SAMPLE_MS;
+        if (since_log_ms >= CONFIG_SYS_MONITOR_LOG_PERIOD_S * 1000) {
+            since_log_ms = 0;
+            sys_monitor_log_line();
+        }
+#endif
+    }
+}
+
+esp_err_t sys_monitor_init(void)
+{
+#if !CONFIG_FREERTOS_USE_TRACE_FACILITY
+#error "sys_monitor needs CONFIG_FREERTOS_USE_TRACE_FACILITY"
+#endif
+#if !CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    ESP_LOGW(TAG, "CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS is off: no per-task CPU figures");
+#endif
+    s_report_mutex = xSemaphoreCreateMutexStatic(&s_report_mutex_buf);
+    if (!xTaskCreateStatic(sysmon_task, "sysmon_task", CONFIG_SYS_MONITOR_TASK_STACK_SIZE, NULL, 1,
+                           s_task_stack, &s_task_tcb)) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
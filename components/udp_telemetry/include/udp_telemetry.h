@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "sample_batch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UDP uplink.
+ *
+ * udp_task follows the sample ring with its own cursor and sends every batch as one
+ * datagram: an 8-byte prefix identifying the device, then a sample_batch payload.
+ * Fire and forget: a batch that cannot be sent is counted and dropped, and the
+ * receiver sees the hole in batch_seq.
+ */
+
+// Datagram prefix: magic 'S' 'E' | version u8 | reserved u8 | device id (last 4 MAC bytes)
+#define UDP_TELEMETRY_MAGIC0        'S'
+#define UDP_TELEMETRY_MAGIC1        'E'
+#define UDP_TELEMETRY_VERSION       2   // 2: protobuf batch payload
+#define UDP_TELEMETRY_PREFIX_BYTES  8
+
+// Counters since boot
+typedef struct {
+    uint32_t batches;           // Batches built
+    uint32_t sent;              // Datagrams handed to the IP stack
+    uint32_t send_errors;       // Datagrams lost locally (no route, no buffers)
+    uint32_t ring_dropped;      // Samples overwritten in the ring before udp_task read them
+} udp_telemetry_stats_t;
+
+#if CONFIG_UDP_TELEMETRY_ENABLE
+// Static RAM taken by udp_task (stack and datagram buffer)
+#define UDP_TELEMETRY_RAM_BYTES (CONFIG_UDP_TELEMETRY_TASK_STACK + UDP_TELEMETRY_PREFIX_BYTES + \
+                                 SAMPLE_BATCH_BYTES(CONFIG_UDP_TELEMETRY_BATCH_SAMPLES))
+#else
+#define UDP_TELEMETRY_RAM_BYTES 0
+#endif
+
+/**
+ * @brief Open the socket and start udp_task
+ *
+ * Safe to call before the station has an address: sends fail and are counted
+ * until it does. Does nothing when CONFIG_UDP_TELEMETRY_ENABLE is off.
+ *
+ * @return esp_err_t ESP_ERR_INVALID_ARG for a bad CONFIG_UDP_TELEMETRY_DEST_ADDR
+ */
+esp_err_t udp_telemetry_start(void);
+
+/**
+ * @brief Copy the uplink counters
+ */
+void udp_telemetry_get_stats(udp_telemetry_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
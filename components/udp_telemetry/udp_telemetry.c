@@ -0,0 +1,155 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "udp_telemetry.h"
+
+#if CONFIG_UDP_TELEMETRY_ENABLE
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_mac.h"
+#include "esp_random.h"
+#include "lwip/sockets.h"
+#include "sample_ring.h"
+#include "dlog.h"
+
+static const char *TAG = "udp_telemetry";
+
+#define BATCH_SAMPLES   CONFIG_UDP_TELEMETRY_BATCH_SAMPLES
+#define TASK_PERIOD_MS  50
+#define STATS_LOG_US    (60 * 1000000LL)
+
+static int s_sock = -1;
+static struct sockaddr_in s_dest;
+static uint16_t s_boot_id;
+static uint32_t s_batch_seq;
+
+// Written by udp_task only; 32-bit fields, no lock
+static udp_telemetry_stats_t s_stats;
+
+static StackType_t s_task_stack[CONFIG_UDP_TELEMETRY_TASK_STACK];
+static StaticTask_t s_task_tcb;
+// Prefix and batch share one buffer so each datagram goes out with a single sendto()
+static uint8_t s_datagram[UDP_TELEMETRY_PREFIX_BYTES + SAMPLE_BATCH_BYTES(BATCH_SAMPLES)];
+static sample_batch_t s_batch;
+
+static void send_batch(void)
+{
+    size_t len = sample_batch_finish(&s_batch, s_boot_id, s_batch_seq++);
+    sample_batch_reset(&s_batch);
+    s_stats.batches++;
+
+    int sent = sendto(s_sock, s_datagram, UDP_TELEMETRY_PREFIX_BYTES + len, 0,
+                      (const struct sockaddr *)&s_dest, sizeof(s_dest));
+    if (sent < 0) {
+        // Mostly "no route" before the first address or during a WiFi outage
+        if (s_stats.send_errors++ == 0) {
+            DLOGW(DLOG_MOD_UPLINK, "udp: sendto failed, errno %d", DLOG_I(errno));
+        }
+        return;
+    }
+    s_stats.sent++;
+}
+
+static void udp_task(void *pvParameters)
+{
+    sample_ring_cursor_t cursor;
+    sample_ring_item_t item;
+    int64_t batch_start_us = 0;
+    int64_t next_log_us = esp_timer_get_time() + STATS_LOG_US;
+
+    sample_ring_cursor_init(&cursor, 0);
+    sample_batch_init(&s_batch, s_datagram + UDP_TELEMETRY_PREFIX_BYTES, BATCH_SAMPLES);
+    while (1) {
+        int64_t now = esp_timer_get_time();
+        while (sample_ring_read(&cursor, &item)) {
+            if (!sample_batch_add(&s_batch, &item)) {
+                send_batch();
+                sample_batch_add(&s_batch, &item);
+            }
+            if (s_batch.count == 1) {
+                batch_start_us = now;
+            }
+            if (s_batch.count == BATCH_SAMPLES) {
+                send_batch();
+            }
+        }
+        s_stats.ring_dropped = cursor.dropped;
+        if (s_batch.count && now - batch_start_us >= CONFIG_UDP_TELEMETRY_BATCH_INTERVAL_MS * 1000LL) {
+            send_batch();
+        }
+
+        if (now >= next_log_us) {
+            next_log_us = now + STATS_LOG_US;
+            DLOGI(DLOG_MOD_UPLINK, "udp: %lu sent, %lu send errors", DLOG_U(s_stats.sent),
+                  DLOG_U(s_stats.send_errors));
+        }
+        vTaskDelay(pdMS_TO_TICKS(TASK_PERIOD_MS));
+    }
+}
+
+esp_err_t udp_telemetry_start(void)
+{
+    memset(&s_dest, 0, sizeof(s_dest));
+    s_dest.sin_family = AF_INET;
+    s_dest.sin_port = htons(CONFIG_UDP_TELEMETRY_PORT);
+    if (inet_aton(CONFIG_UDP_TELEMETRY_DEST_ADDR, &s_dest.sin_addr) == 0) {
+        ESP_LOGE(TAG, "Bad destination address \"%s\"", CONFIG_UDP_TELEMETRY_DEST_ADDR);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s_sock < 0) {
+        ESP_LOGE(TAG, "socket() failed, errno %d", errno);
+        return ESP_FAIL;
+    }
+    if (IN_MULTICAST(ntohl(s_dest.sin_addr.s_addr))) {
+        uint8_t ttl = CONFIG_UDP_TELEMETRY_MULTICAST_TTL;
+        setsockopt(s_sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    }
+
+    // Constant prefix: written once, every batch is encoded right behind it
+    uint8_t mac[6];
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    s_datagram[0] = UDP_TELEMETRY_MAGIC0;
+    s_datagram[1] = UDP_TELEMETRY_MAGIC1;
+    s_datagram[2] = UDP_TELEMETRY_VERSION;
+    s_datagram[3] = 0;
+    memcpy(&s_datagram[4], &mac[2], 4);
+    s_boot_id = (uint16_t)esp_random();
+
+    // Same priority as mqtt_pub: below sampling and display
+    if (!xTaskCreateStatic(udp_task, "udp_task", CONFIG_UDP_TELEMETRY_TASK_STACK, NULL, 1,
+                           s_task_stack, &s_task_tcb)) {
+        close(s_sock);
+        s_sock = -1;
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Streaming to %s:%d (boot %04x)", CONFIG_UDP_TELEMETRY_DEST_ADDR,
+             CONFIG_UDP_TELEMETRY_PORT, s_boot_id);
+    return ESP_OK;
+}
+
+void udp_telemetry_get_stats(udp_telemetry_stats_t *out)
+{
+    *out = s_stats;
+}
+
+#else // !CONFIG_UDP_TELEMETRY_ENABLE
+
+esp_err_t udp_telemetry_start(void)
+{
+    return ESP_OK;
+}
+
+void udp_telemetry_get_stats(udp_telemetry_stats_t *out)
+{
+    *out = (udp_telemetry_stats_t){ 0 };
+}
+
+#endif
@@ -10,9 +10,19 @@
 #define TRIG_PIN GPIO_NUM_8  // GPIO 6 cho TRIG
 #define ECHO_PIN GPIO_NUM_7  // GPIO 7 cho ECHO
 
+// Một mẫu đo, kèm số thứ tự và thời điểm phát xung TRIG (dùng cho tracing)
+typedef struct {
+    uint32_t seq;           // Monotonic sample number, assigned by the caller
+    int64_t t_trigger_us;   // esp_timer time of the TRIG pulse
+    float distance;         // Distance in cm, -1 on echo timeout
+} ultrasonic_sample_t;
+
 // Khởi tạo cảm biến siêu âm
 void ultrasonic_init(void);
 
+// Đo một mẫu: điền t_trigger_us và distance (seq do người gọi đặt)
+void ultrasonic_read_sample(ultrasonic_sample_t *sample);
+
 // Đọc khoảng cách (cm)
 float read_ultrasonic_distance(void);
 
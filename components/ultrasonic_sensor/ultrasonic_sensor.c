@@ -31,6 +31,12 @@ void ultrasonic_init(void)
     ESP_LOGI(TAG, "Ultrasonic sensor initialized");
 }
 
+void ultrasonic_read_sample(ultrasonic_sample_t *sample)
+{
+    sample->t_trigger_us = esp_timer_get_time();
+    sample->distance = read_ultrasonic_distance();
+}
+
 float read_ultrasonic_distance(void)
 {
     uint32_t start_time, end_time;
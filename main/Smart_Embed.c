@@ -4,16 +4,35 @@
  */
 
 #include <stdio.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "oled_driver.h"
+#include "display_ui.h"
+#if CONFIG_OLED_DRIVER_BENCHMARK
+#include "oled_bench.h"
+#endif
 #include "ultrasonic_sensor.h"
 #include "driver/gpio.h"
 #include "http_server_app.h"
 #include "esp32c3_wifi.h"
 #include "freertos/queue.h"
 #include "sd_card_spi.h"
+#include "log_store.h"
+#include "flash_log.h"
+#include "dlog.h"
+#include "sample_trace.h"
+#include "sample_ring.h"
+#include "sys_monitor.h"
+#include "boot_prof.h"
+#include "mqtt_telemetry.h"
+#include "udp_telemetry.h"
+#include "sample_stats.h"
+#include "distance_hist.h"
+#include "occupancy.h"
+#include "approach_tracker.h"
+#include "esp_event.h"
 
 static const char *TAG = "smart_embed";
 // Queue for LED control
@@ -24,55 +43,214 @@ QueueHandle_t distance_queue = NULL;
 static oled_driver_t *g_oled = NULL;
 float g_distance = 0.0f;
 bool g_distance_valid = false;
+volatile uint32_t g_distance_seq = 0; // seq of the sample behind g_distance
 volatile int g_led_status = 0; // 0: off, 1: on
 
-// LED configuration
+// LED configuration (ngưỡng bật/tắt: menuconfig "Occupancy events")
 #define LED_PIN 2
-#define DISTANCE_THRESHOLD 10.0f  // 10cm threshold
+
+// Queue depths
+#define LED_QUEUE_LEN      4
+#define DISTANCE_QUEUE_LEN 8
 
 // Task handles
 static TaskHandle_t display_task_handle = NULL;
 static TaskHandle_t sensor_task_handle = NULL;
 static TaskHandle_t led_task_handle = NULL;
-static TaskHandle_t http_server_task_handle = NULL;
 static TaskHandle_t sdcard_task_handle = NULL;
+static TaskHandle_t stats_task_handle = NULL;
+
+#if CONFIG_SMART_EMBED_STATIC_ALLOC
+// Stack, TCB và queue storage nằm trong .bss: không lấy từ heap, thấy được ở `idf.py size-components`
+static StackType_t sensor_task_stack[CONFIG_SMART_EMBED_SENSOR_STACK];
+static StackType_t display_task_stack[CONFIG_SMART_EMBED_DISPLAY_STACK];
+static StackType_t led_task_stack[CONFIG_SMART_EMBED_LED_STACK];
+static StackType_t sdcard_task_stack[CONFIG_SMART_EMBED_SDCARD_STACK];
+static StackType_t stats_task_stack[CONFIG_SMART_EMBED_STATS_STACK];
+static StaticTask_t sensor_task_tcb;
+static StaticTask_t display_task_tcb;
+static StaticTask_t led_task_tcb;
+static StaticTask_t sdcard_task_tcb;
+static StaticTask_t stats_task_tcb;
+
+static uint8_t led_queue_storage[LED_QUEUE_LEN * sizeof(int)];
+static uint8_t distance_queue_storage[DISTANCE_QUEUE_LEN * sizeof(ultrasonic_sample_t)];
+static StaticQueue_t led_queue_buf;
+static StaticQueue_t distance_queue_buf;
+#define TASK_STORAGE(name) name##_stack, &name##_tcb
+#else
+#define TASK_STORAGE(name) NULL, NULL
+#endif
+
+// RAM budget per subsystem (bytes); stacks and queues are heap-backed when static allocation is off
+#define APP_STACK_BYTES  (CONFIG_SMART_EMBED_SENSOR_STACK + CONFIG_SMART_EMBED_DISPLAY_STACK + \
+                          CONFIG_SMART_EMBED_LED_STACK + CONFIG_SMART_EMBED_SDCARD_STACK + \
+                          CONFIG_SMART_EMBED_STATS_STACK)
+#define APP_QUEUE_BYTES  (LED_QUEUE_LEN * sizeof(int) + DISTANCE_QUEUE_LEN * sizeof(ultrasonic_sample_t))
+#if CONFIG_OLED_DRIVER_STATIC_ALLOC
+#define OLED_FB_BYTES    OLED_DRIVER_FB_BYTES
+#else
+#define OLED_FB_BYTES    0
+#endif
+#if CONFIG_OLED_DRIVER_STATIC_ALLOC && CONFIG_OLED_DRIVER_ASYNC_FLUSH
+#define OLED_STACK_BYTES CONFIG_OLED_DRIVER_FLUSH_TASK_STACK
+#else
+#define OLED_STACK_BYTES 0
+#endif
+#if CONFIG_DLOG_CONSOLE_TASK
+#define DLOG_STACK_BYTES CONFIG_DLOG_TASK_STACK_SIZE
+#else
+#define DLOG_STACK_BYTES 0
+#endif
+#define APP_RAM_BYTES    (APP_STACK_BYTES + APP_QUEUE_BYTES + OLED_FB_BYTES + OLED_STACK_BYTES + \
+                          DLOG_RAM_BYTES + DLOG_STACK_BYTES + CONFIG_SYS_MONITOR_TASK_STACK_SIZE + \
+                          SAMPLE_RING_RAM_BYTES + MQTT_TELEMETRY_RAM_BYTES + \
+                          UDP_TELEMETRY_RAM_BYTES + SAMPLE_STATS_RAM_BYTES + OCCUPANCY_RAM_BYTES + \
+                          DISTANCE_HIST_RAM_BYTES + LOG_STORE_RAM_BYTES + FLASH_LOG_RAM_BYTES)
+
+#if CONFIG_SMART_EMBED_STATIC_ALLOC
+_Static_assert(APP_RAM_BYTES <= CONFIG_SMART_EMBED_RAM_BUDGET,
+               "Static RAM exceeds CONFIG_SMART_EMBED_RAM_BUDGET");
+#endif
+
+static TaskHandle_t create_task(TaskFunction_t fn, const char *name, uint32_t stack_size,
+                                UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb)
+{
+#if CONFIG_SMART_EMBED_STATIC_ALLOC
+    return xTaskCreateStatic(fn, name, stack_size, NULL, priority, stack, tcb);
+#else
+    TaskHandle_t handle = NULL;
+    xTaskCreate(fn, name, stack_size, NULL, priority, &handle);
+    return handle;
+#endif
+}
+
+// Bảng ngân sách RAM in lúc khởi động (dùng cùng với `idf.py size-components` để xem phía linker)
+static void log_memory_budget(void)
+{
+    static const struct {
+        const char *name;
+        uint32_t bytes;
+    } rows[] = {
+        { "task stacks",      APP_STACK_BYTES },
+        { "queues",           APP_QUEUE_BYTES },
+        { "oled framebuffer", OLED_FB_BYTES },
+        { "oled_flush stack", OLED_STACK_BYTES },
+        { "dlog ring",        DLOG_RAM_BYTES },
+        { "sample ring",      SAMPLE_RING_RAM_BYTES },
+        { "dlog_task stack",  DLOG_STACK_BYTES },
+        { "sysmon_task stack", CONFIG_SYS_MONITOR_TASK_STACK_SIZE },
+        { "mqtt_pub",         MQTT_TELEMETRY_RAM_BYTES },
+        { "udp_task",         UDP_TELEMETRY_RAM_BYTES },
+        { "sample stats",     SAMPLE_STATS_RAM_BYTES },
+        { "occupancy events", OCCUPANCY_RAM_BYTES },
+        { "histograms",       DISTANCE_HIST_RAM_BYTES },
+        { "log tails",        LOG_STORE_RAM_BYTES },
+        { "flash log",        FLASH_LOG_RAM_BYTES },
+    };
+    ESP_LOGI(TAG, "RAM budget (%s):", CONFIG_SMART_EMBED_STATIC_ALLOC ? "static" : "heap");
+    for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); i++) {
+        ESP_LOGI(TAG, "  %-18s %6" PRIu32, rows[i].name, rows[i].bytes);
+    }
+    ESP_LOGI(TAG, "  %-18s %6" PRIu32 " / %d", "total", (uint32_t)APP_RAM_BYTES,
+             CONFIG_SMART_EMBED_RAM_BUDGET);
+}
 // Task functions
 static void sdcard_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "SD Card task started");
+    // Sự kiện occupancy xảy ra trong lúc mount chờ trong event ring và được ghi sau đó
+    occupancy_cursor_t events;
+    occupancy_cursor_init(&events, 0);
+    // Mount here rather than in app_main: card detection and FAT mount take hundreds of ms
+    // and must not delay sampling; samples wait in distance_queue meanwhile
+    if (sdcard_init()) {
+        boot_prof_mark(BOOT_PHASE_SD_READY);
+    } else {
+        ESP_LOGE(TAG, "SD card init failed! Logging to internal flash");
+    }
+    // Seq của các mẫu đã vào RAM tail nhưng chưa lên thẻ (để đánh dấu SD_FLUSHED khi ghi xong).
+    // Chỉ giữ SAMPLE_TRACE_WINDOW mẫu cuối: mẫu cũ hơn đã rời trace window
+    uint32_t unflushed[SAMPLE_TRACE_WINDOW];
+    uint32_t unflushed_n = 0;
     while (1) {
-        float distance = 0.0f;
-        // Nhận dữ liệu từ queue (block tối đa 1 giây)
-        if (xQueuePeek(distance_queue, &distance, pdMS_TO_TICKS(1000)) == pdTRUE) {
-            long long timestamp = esp_timer_get_time() / 1000; // ms
-            if (!sdcard_save_sensor_data(distance, timestamp)) {
-                ESP_LOGE(TAG, "Failed to save sensor data to SD card");
+        ultrasonic_sample_t sample;
+        // Nhận dữ liệu từ queue (block tối đa 1 giây); mỗi mẫu chỉ được ghi một lần
+        if (xQueueReceive(distance_queue, &sample, pdMS_TO_TICKS(1000)) == pdTRUE) {
+            sample_trace_mark(sample.seq, SAMPLE_STAGE_SD_STAGED);
+            long long timestamp = sample.t_trigger_us / 1000; // ms
+            if (!sdcard_save_sensor_data(sample.distance, timestamp)) {
+                DLOGE(DLOG_MOD_SD, "Failed to save sensor data to SD card");
             } else {
-                ESP_LOGI(TAG, "Saved: %.2f cm, %lld ms", distance, timestamp);
+                unflushed[unflushed_n++ % SAMPLE_TRACE_WINDOW] = sample.seq;
+                DLOGI(DLOG_MOD_SD, "Saved: %.2f cm, %lu.%03lu s", DLOG_F(sample.distance),
+                      DLOG_U(timestamp / 1000), DLOG_U(timestamp % 1000));
+            }
+        }
+        // Một lần ghi + fsync cho cả lô, khi dòng cũ nhất quá CONFIG_LOG_STORE_COMMIT_MS.
+        // Lô nằm lại trong flash (thẻ vắng/lỗi) không tính là SD_FLUSHED
+        if (log_store_commit(LOG_STORE_SENSOR, false) == ESP_OK && unflushed_n) {
+            if (!log_store_parked()) {
+                for (uint32_t i = unflushed_n > SAMPLE_TRACE_WINDOW ? unflushed_n - SAMPLE_TRACE_WINDOW : 0;
+                     i < unflushed_n; i++) {
+                    sample_trace_mark(unflushed[i % SAMPLE_TRACE_WINDOW], SAMPLE_STAGE_SD_FLUSHED);
+                }
+            }
+            unflushed_n = 0;
+        }
+        // Event log riêng (events.csv): vài dòng mỗi lần có người đến/đi, không phải quét sensor.csv
+        occupancy_event_t ev;
+        while (occupancy_read(&events, &ev)) {
+            if (!sdcard_save_event(ev.seq, occupancy_event_name(ev.type), ev.t_ms, ev.dwell_ms, ev.distance_mm)) {
+                DLOGE(DLOG_MOD_SD, "Failed to save event %lu", DLOG_U(ev.seq));
             }
         }
-        // Có thể delay nhẹ nếu muốn
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // Sự kiện hiếm nhưng quan trọng: commit ngay (không có gì thì trả về luôn)
+        log_store_commit(LOG_STORE_EVENTS, true);
+        // Thẻ rút ra/lỗi liên tục: unmount, mount lại theo backoff; commit sau đó chuyển dần dữ liệu
+        // từ flash về thẻ. sensor_task không bao giờ chờ ở đây (xQueueSend không timeout)
+        sdcard_service();
     }
 }
 static void sensor_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "Sensor task started");
     
+    uint32_t seq = 0;
     while (1) {
         // Read distance from ultrasonic sensor
-        float distance = read_ultrasonic_distance();
+        ultrasonic_sample_t sample = { .seq = ++seq };
+        ultrasonic_read_sample(&sample);
+        boot_prof_mark(BOOT_PHASE_FIRST_SAMPLE);
+        sample_trace_begin(sample.seq, sample.t_trigger_us);
+        float distance = sample.distance;
         
         // Update global variables
         if (distance > 0 && distance < 400) {  // Valid distance range (2cm - 4m)
+            sample_trace_mark(sample.seq, SAMPLE_STAGE_FILTER);
             g_distance = distance;
             g_distance_valid = true;
-            xQueueSend(distance_queue, &distance, 0); // Gửi dữ liệu vào queue
-            ESP_LOGI(TAG, "Distance: %.1f cm", distance);
+            g_distance_seq = sample.seq;
+            sample_trace_mark(sample.seq, SAMPLE_STAGE_SNAPSHOT);
+            xQueueSend(distance_queue, &sample, 0); // Gửi dữ liệu vào queue
+            DLOGI(DLOG_MOD_SENSOR, "Distance: %.1f cm", DLOG_F(distance));
         } else {
             g_distance = 0.0f;
             g_distance_valid = false;
-            ESP_LOGW(TAG, "Distance reading error or out of range");
+            DLOGW(DLOG_MOD_SENSOR, "Distance reading error or out of range");
+        }
+
+        // Mọi mẫu (kể cả mẫu lỗi) vào sample ring cho các consumer đọc theo cursor riêng
+        sample_ring_item_t item = {
+            .seq = sample.seq,
+            .t_us = sample.t_trigger_us,
+            .distance = distance,
+            .valid = g_distance_valid,
+        };
+        sample_ring_push(&item);
+        // Đánh thức led_task ngay: cảnh báo không phải chờ thêm tới 100 ms polling
+        if (led_task_handle) {
+            xTaskNotifyGive(led_task_handle);
         }
         
         // Wait 500ms before next reading
@@ -83,42 +261,73 @@ static void sensor_task(void *pvParameters)
 static void display_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "Display task started");
-    
-    // Display initial title
-    oled_clear(g_oled);
-    oled_display_text(g_oled, "Distance Logger", 64, 5, OLED_FONT_SMALL, OLED_ALIGN_CENTER);
-    oled_display_text(g_oled, "Smart Embed", 64, 20, OLED_FONT_SMALL, OLED_ALIGN_CENTER);
-    oled_draw_line(g_oled, 0, 30, 127, 30, 1);
-    oled_update(g_oled);
+    uint32_t frame = 0;
+
+    // Widget giữ giá trị cũ: khoảng cách không đổi thì không vẽ lại, không có byte nào lên I2C
+    // Bố cục nằm trong display_ui để tools/oled_host vẽ đúng các màn hình này trên Linux
+    static display_ui_t ui;
+    display_ui_init(&ui);
+
+    // Display initial title (một frame: chỉ flush một lần ở oled_end_frame)
+    oled_begin_frame(g_oled);
+    display_ui_draw_static(g_oled, &ui);
+    oled_end_frame(g_oled);
+
+    // Biểu đồ xu hướng đọc từng mẫu mới từ sample ring: mỗi mẫu = cuộn 1 cột + vẽ 1 cột
+    sample_ring_cursor_t cursor;
+    sample_ring_cursor_init(&cursor, 0);
     
     while (1) {
-        // Clear the distance display area
-        oled_draw_rectangle(g_oled, 5, 35, 118, 25, 1, 0);  // Clear area with black rectangle
-        
-        if (g_distance_valid) {
-            // float distance_q = 0.0f;
-            // xQueuePeek(distance_queue, &distance_q, portMAX_DELAY);
-            // Display distance
-            char distance_str[20];
-            sprintf(distance_str, "Distance: %.1f cm", g_distance);
-            oled_display_text(g_oled, distance_str, 64, 40, OLED_FONT_SMALL, OLED_ALIGN_CENTER);
-            
-            // Display status
-            oled_display_text(g_oled, "Status: OK", 64, 50, OLED_FONT_SMALL, OLED_ALIGN_CENTER);
-        } else {
-            // Display error
-            oled_display_text(g_oled, "Distance: ERROR", 64, 40, OLED_FONT_SMALL, OLED_ALIGN_CENTER);
-            oled_display_text(g_oled, "Status: OUT OF RANGE", 64, 55, OLED_FONT_SMALL, OLED_ALIGN_CENTER);
+        bool valid = g_distance_valid;
+        float d = g_distance;
+
+        oled_begin_frame(g_oled);
+        sample_ring_item_t item;
+        while (sample_ring_read(&cursor, &item)) {
+            display_ui_push_sample(g_oled, &ui, item.distance, item.valid);
+        }
+        if (frame % 25 == 0) {
+            // Dòng trạng thái hiện trung bình / p95 của 1 giờ; đổi chậm nên chỉ hỏi mỗi ~5 s
+            sample_rollup_t hour;
+            bool have = sample_stats_get(SAMPLE_STATS_1H, &hour) == ESP_OK && hour.valid > 0;
+            display_ui_set_stats(&ui, hour.mean_cm, hour.p95_cm, have);
+        }
+        display_ui_show(g_oled, &ui, d, valid);
+        // Update display: only widgets that changed are dirty, sent by the flush task
+        oled_end_frame(g_oled);
+        boot_prof_mark(BOOT_PHASE_FIRST_FRAME);
+
+        if (++frame % 50 == 0) {
+            oled_stats_t st;
+            oled_get_stats(g_oled, &st);
+            DLOGD(DLOG_MOD_DISPLAY, "frames %lu dropped %lu latency avg %lu max %lu us",
+                  DLOG_U(st.frames), DLOG_U(st.dropped), DLOG_U(st.latency_avg_us), DLOG_U(st.latency_max_us));
         }
-        
-        // Update display
-        oled_update(g_oled);
         
         // Wait 200ms before next display update
         vTaskDelay(pdMS_TO_TICKS(200));
     }
 }
 
+static void stats_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Stats task started");
+    // Cursor riêng: thống kê thấy mọi mẫu (kể cả mẫu lỗi) mà không làm chậm sensor_task
+    sample_ring_cursor_t cursor;
+    sample_ring_cursor_init(&cursor, 0);
+
+    while (1) {
+        sample_ring_item_t item;
+        while (sample_ring_read(&cursor, &item)) {
+            sample_stats_add(&item);
+            distance_hist_add(&item);
+        }
+        // Ghi histogram của ngày vừa xong lên thẻ SD (một dòng mỗi ngày)
+        distance_hist_persist();
+        vTaskDelay(pdMS_TO_TICKS(200));
+    }
+}
+
 static void led_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "LED task started");
@@ -135,60 +344,50 @@ static void led_task(void *pvParameters)
     
     // Initialize LED off
     gpio_set_level(LED_PIN, 0);
+
+    // Mọi mẫu đi qua bộ phát hiện occupancy (hysteresis + dwell + debounce): LED theo trạng thái
+    // đã lọc thay vì so sánh g_distance với một ngưỡng, nên không nhấp nháy khi vật ở sát ngưỡng.
+    // approach_tracker bật LED sớm hơn khi vật đang tiến lại và sẽ vượt ngưỡng trong horizon
+    sample_ring_cursor_t cursor;
+    sample_ring_cursor_init(&cursor, 0);
+    bool alert = false;
     
     while (1) {
-        // Check if distance is valid and below threshold
-        if (g_distance_valid && g_distance < DISTANCE_THRESHOLD) {
-            // Turn LED on
-            gpio_set_level(LED_PIN, 1);
-            g_led_status = 1;
-            ESP_LOGI(TAG, "LED ON - Distance: %.1f cm < %.1f cm", g_distance, DISTANCE_THRESHOLD);
-        } else {
-            // Turn LED off
-            gpio_set_level(LED_PIN, 0);
-            g_led_status = 0;
+        sample_ring_item_t item;
+        while (sample_ring_read(&cursor, &item)) {
+            alert = approach_tracker_update(&item);
+            occupancy_update(&item);
+            sample_trace_mark(item.seq, SAMPLE_STAGE_LED);
+        }
+        int on = (occupancy_present() || alert) ? 1 : 0;
+        if (on != g_led_status) {
+            gpio_set_level(LED_PIN, on);
+            g_led_status = on;
         }
         
-        // Check every 100ms for responsive LED control
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // Chạy ngay khi sensor_task đẩy mẫu mới; timeout 100 ms chỉ là lưới an toàn
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
     }
 }
 
-static void http_server_task(void *pvParameters)
-{
-    ESP_LOGI(TAG, "HTTP Server task started");
-    
-    // Wait a bit for WiFi to be ready
-    vTaskDelay(pdMS_TO_TICKS(5000));
-    
-    // Start HTTP server
-    start_webserver();
-    ESP_LOGI(TAG, "HTTP Server started on http://192.168.x.x");
-    
-    // Keep task running
-    while (1) {
-        // Monitor HTTP server status
-        vTaskDelay(pdMS_TO_TICKS(30000));  // Check every 30 seconds
-        ESP_LOGI(TAG, "HTTP Server running - Distance: %.1f cm, LED: %s", 
-                 g_distance, (g_distance_valid && g_distance < DISTANCE_THRESHOLD) ? "ON" : "OFF");
-    }
-}
-
-
 void app_main(void)
 {
+    boot_prof_mark(BOOT_PHASE_APP_MAIN);
     ESP_LOGI(TAG, "Starting Smart Distance Logger & Display");
+    // Deferred logging for the task hot paths
+    dlog_init();
     // Create queue for LED control
-    led_queue = xQueueCreate(4, sizeof(int)); // Tạo queue cho LED
-    distance_queue = xQueueCreate(8, sizeof(float)); // Tạo queue cho dữ liệu khoảng cách
-    
-    // SD card initialization
-    if (!sdcard_init()) {
-        ESP_LOGE(TAG, "SD card init failed!");
-        // Có thể return hoặc chỉ log lỗi
-    }
-    // Initialize WiFi AP using component
-    wifi_init_sta();
+#if CONFIG_SMART_EMBED_STATIC_ALLOC
+    led_queue = xQueueCreateStatic(LED_QUEUE_LEN, sizeof(int), led_queue_storage, &led_queue_buf);
+    distance_queue = xQueueCreateStatic(DISTANCE_QUEUE_LEN, sizeof(ultrasonic_sample_t),
+                                        distance_queue_storage, &distance_queue_buf);
+#else
+    led_queue = xQueueCreate(LED_QUEUE_LEN, sizeof(int)); // Tạo queue cho LED
+    distance_queue = xQueueCreate(DISTANCE_QUEUE_LEN, sizeof(ultrasonic_sample_t)); // Tạo queue cho dữ liệu khoảng cách
+#endif
+
+    // Khởi động theo thứ tự "nhanh trước, chậm sau": OLED và cảm biến chỉ mất vài ms, nên
+    // sensor/display chạy ngay; SD mount trong sdcard_task, WiFi kết nối nền, HTTP bật khi có IP
 
     // Configure OLED
     oled_config_t config = {
@@ -207,56 +406,88 @@ void app_main(void)
         ESP_LOGE(TAG, "Failed to initialize OLED: %s", esp_err_to_name(ret));
         return;
     }
+    boot_prof_mark(BOOT_PHASE_OLED_READY);
+
+#if CONFIG_OLED_DRIVER_BENCHMARK
+    oled_bench_run(g_oled);
+#endif
 
     // Initialize ultrasonic sensor
     ultrasonic_init();
+    boot_prof_mark(BOOT_PHASE_SENSOR_READY);
     ESP_LOGI(TAG, "Ultrasonic sensor initialized");
 
-    ESP_LOGI(TAG, "System initialized successfully");
-
     // Create sensor task (higher priority)
-    xTaskCreate(sensor_task, "sensor_task", 4096, NULL, 3, &sensor_task_handle);
+    sensor_task_handle = create_task(sensor_task, "sensor_task", CONFIG_SMART_EMBED_SENSOR_STACK, 3,
+                                     TASK_STORAGE(sensor_task));
     if (sensor_task_handle == NULL) {
         ESP_LOGE(TAG, "Failed to create sensor task");
         return;
     }
 
     // Create display task (lower priority)
-    xTaskCreate(display_task, "display_task", 4096, NULL, 2, &display_task_handle);
+    display_task_handle = create_task(display_task, "display_task", CONFIG_SMART_EMBED_DISPLAY_STACK, 2,
+                                      TASK_STORAGE(display_task));
     if (display_task_handle == NULL) {
         ESP_LOGE(TAG, "Failed to create display task");
         return;
     }
 
     // Create LED task (medium priority)
-    xTaskCreate(led_task, "led_task", 2048, NULL, 2, &led_task_handle);
+    led_task_handle = create_task(led_task, "led_task", CONFIG_SMART_EMBED_LED_STACK, 2,
+                                  TASK_STORAGE(led_task));
     if (led_task_handle == NULL) {
         ESP_LOGE(TAG, "Failed to create LED task");
         return;
     }
 
-    // Create HTTP server task (low priority)
-    xTaskCreate(http_server_task, "http_server_task", 8192, NULL, 1, &http_server_task_handle);
-    if (http_server_task_handle == NULL) {
-        ESP_LOGE(TAG, "Failed to create HTTP server task");
-        return;
+    // Create SD card task (medium priority); it mounts the card itself.
+    // log_store trước: HTTP có thể đọc lịch sử trước khi thẻ được mount
+    ESP_ERROR_CHECK(log_store_init(SDCARD_MOUNT_POINT));
+    // Flash dự phòng khi thẻ vắng hoặc lỗi; không có partition thì dòng chỉ nằm trong RAM tail
+    log_backend_t *flash_log = NULL;
+    if (flash_log_init(&flash_log) == ESP_OK) {
+        log_store_set_fallback(flash_log);
     }
-    // Create SD card task (medium priority)
-    xTaskCreate(sdcard_task, "sdcard_task", 4096, NULL, 2, &sdcard_task_handle);
+    sdcard_task_handle = create_task(sdcard_task, "sdcard_task", CONFIG_SMART_EMBED_SDCARD_STACK, 2,
+                                     TASK_STORAGE(sdcard_task));
     if (sdcard_task_handle == NULL) {
         ESP_LOGE(TAG, "Failed to create SD card task");
         return;
     }
 
+    // Streaming statistics and histograms (GET /stats, /hist, OLED status line); lowest priority, O(1) per sample
+    ESP_ERROR_CHECK(sample_stats_init());
+    ESP_ERROR_CHECK(distance_hist_init());
+    stats_task_handle = create_task(stats_task, "stats_task", CONFIG_SMART_EMBED_STATS_STACK, 1,
+                                    TASK_STORAGE(stats_task));
+    if (stats_task_handle == NULL) {
+        ESP_LOGE(TAG, "Failed to create stats task");
+        return;
+    }
+    boot_prof_mark(BOOT_PHASE_TASKS_STARTED);
+
+    // HTTP server follows the link state: start on GOT_IP, stop on disconnect, start again
+    // on reconnect. Handlers are registered before WiFi starts so the first address is not missed.
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    ESP_ERROR_CHECK(http_server_app_start_on_ip());
+    // Initialize WiFi station using component (returns without waiting for the connection)
+    wifi_init_sta();
+    // MQTT uplink: the client connects once there is an address; batches spool to SD until then
+    if (mqtt_telemetry_start() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start MQTT telemetry");
+    }
+    // Optional UDP stream (CONFIG_UDP_TELEMETRY_ENABLE) for high-rate collection
+    if (udp_telemetry_start() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start UDP telemetry");
+    }
+
     ESP_LOGI(TAG, "All tasks created successfully");
+    log_memory_budget();
 
-    // Main task just waits (or can be used for other purposes)
-    while (1) {
-        // Monitor system health or handle other tasks
-        vTaskDelay(pdMS_TO_TICKS(10000));  // Check every 10 seconds
-        
-        bool led_status = (g_distance_valid && g_distance < DISTANCE_THRESHOLD);
-        ESP_LOGI(TAG, "System running - Distance: %.1f cm, Valid: %s, LED: %s", 
-                 g_distance, g_distance_valid ? "Yes" : "No", led_status ? "ON" : "OFF");
+    // Health monitoring (per-task CPU, stack high-water marks, heap) runs in sysmon_task,
+    // which also prints the periodic status line; app_main returns and frees its stack.
+    if (sys_monitor_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start system monitor");
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""HTTP load generator for the Smart_Embed web server.
+
+Drives a fixed set of endpoints at a configurable concurrency and reports
+throughput and p50/p99/p999 latency per endpoint. Works against the host
+build in this directory (idf.py --preview set-target linux) or a real board.
+
+    ./loadgen.py --host 127.0.0.1 --port 8080 -c 4 -d 20
+    ./loadgen.py --host 192.168.1.50 --path /ultrasonic --json result.json
+"""
+
+import argparse
+import http.client
+import json
+import sys
+import threading
+import time
+from collections import defaultdict
+
+DEFAULT_PATHS = ["/ultrasonic", "/sensor/history", "/"]
+
+
+def percentile(sorted_values, pct):
+    if not sorted_values:
+        return 0.0
+    k = (len(sorted_values) - 1) * pct / 100.0
+    lo = int(k)
+    hi = min(lo + 1, len(sorted_values) - 1)
+    return sorted_values[lo] + (sorted_values[hi] - sorted_values[lo]) * (k - lo)
+
+
+class Worker(threading.Thread):
+    """One keep-alive connection issuing requests round-robin over the paths."""
+
+    def __init__(self, args, paths, offset, deadline):
+        super().__init__(daemon=True)
+        self.args = args
+        self.paths = paths
+        self.offset = offset
+        self.deadline = deadline
+        self.latencies = defaultdict(list)   # path -> [seconds]
+        self.errors = defaultdict(int)       # path -> count
+        self.bytes = 0
+
+    def _connect(self):
+        return http.client.HTTPConnection(self.args.host, self.args.port,
+                                          timeout=self.args.timeout)
+
+    def run(self):
+        conn = self._connect()
+        i = self.offset
+        while time.monotonic() < self.deadline:
+            path = self.paths[i % len(self.paths)]
+            i += 1
+            start = time.perf_counter()
+            try:
+                conn.request("GET", path)
+                resp = conn.getresponse()
+                body = resp.read()
+                elapsed = time.perf_counter() - start
+                if resp.status != 200:
+                    self.errors[path] += 1
+                else:
+                    self.latencies[path].append(elapsed)
+                    self.bytes += len(body)
+                if resp.getheader("Connection", "").lower() == "close":
+                    conn.close()
+                    conn = self._connect()
+            except (OSError, http.client.HTTPException):
+                self.errors[path] += 1
+                conn.close()
+                conn = self._connect()
+        conn.close()
+
+
+def run(args):
+    paths = args.path or DEFAULT_PATHS
+    if args.warmup > 0:
+        warm = Worker(args, paths, 0, time.monotonic() + args.warmup)
+        warm.run()
+
+    deadline = time.monotonic() + args.duration
+    workers = [Worker(args, paths, n, deadline) for n in range(args.concurrency)]
+    start = time.monotonic()
+    for w in workers:
+        w.start()
+    for w in workers:
+        w.join()
+    wall = time.monotonic() - start
+
+    report = {"concurrency": args.concurrency, "duration_s": round(wall, 3),
+              "endpoints": {}}
+    all_lat = []
+    total_err = 0
+    for path in paths:
+        lat = sorted(l for w in workers for l in w.latencies[path])
+        err = sum(w.errors[path] for w in workers)
+        all_lat.extend(lat)
+        total_err += err
+        report["endpoints"][path] = summarize(lat, err, wall)
+    report["total"] = summarize(sorted(all_lat), total_err, wall)
+    report["total"]["bytes"] = sum(w.bytes for w in workers)
+    return report
+
+
+def summarize(sorted_lat, errors, wall):
+    ms = 1000.0
+    return {
+        "requests": len(sorted_lat),
+        "errors": errors,
+        "rps": round(len(sorted_lat) / wall, 2) if wall > 0 else 0.0,
+        "p50_ms": round(percentile(sorted_lat, 50) * ms, 3),
+        "p99_ms": round(percentile(sorted_lat, 99) * ms, 3),
+        "p999_ms": round(percentile(sorted_lat, 99.9) * ms, 3),
+        "max_ms": round((sorted_lat[-1] if sorted_lat else 0.0) * ms, 3),
+    }
+
+
+def print_report(report):
+    print(f"concurrency={report['concurrency']} duration={report['duration_s']}s")
+    print(f"{'endpoint':<20}{'req':>8}{'err':>6}{'req/s':>10}"
+          f"{'p50 ms':>10}{'p99 ms':>10}{'p999 ms':>10}{'max ms':>10}")
+    rows = list(report["endpoints"].items()) + [("TOTAL", report["total"])]
+    for name, r in rows:
+        print(f"{name:<20}{r['requests']:>8}{r['errors']:>6}{r['rps']:>10}"
+              f"{r['p50_ms']:>10}{r['p99_ms']:>10}{r['p999_ms']:>10}{r['max_ms']:>10}")
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("--host", default="127.0.0.1")
+    p.add_argument("--port", type=int, default=8080)
+    p.add_argument("-c", "--concurrency", type=int, default=4,
+                   help="parallel keep-alive connections (httpd default allows 7)")
+    p.add_argument("-d", "--duration", type=float, default=10.0, help="seconds")
+    p.add_argument("--warmup", type=float, default=1.0, help="seconds, single connection")
+    p.add_argument("--timeout", type=float, default=5.0, help="per-request timeout (s)")
+    p.add_argument("--path", action="append",
+                   help="endpoint to hit (repeatable); default: %s" % " ".join(DEFAULT_PATHS))
+    p.add_argument("--json", metavar="FILE", help="also write the report as JSON")
+    p.add_argument("--max-p99-ms", type=float,
+                   help="exit 1 if the overall p99 exceeds this (CI regression gate)")
+    args = p.parse_args()
+
+    report = run(args)
+    print_report(report)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(report, f, indent=2)
+
+    if report["total"]["requests"] == 0:
+        return 1
+    if args.max_p99_ms is not None and report["total"]["p99_ms"] > args.max_p99_ms:
+        print(f"p99 {report['total']['p99_ms']} ms exceeds limit {args.max_p99_ms} ms",
+              file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "http_server_app.h"
+#include "sample_trace.h"
+#include "sample_stats.h"
+#include "distance_hist.h"
+#include "log_store.h"
+#include "occupancy.h"
+#include "approach_tracker.h"
+
+static const char *TAG = "http_bench";
+
+#define BENCH_DATA_DIR CONFIG_HTTP_SERVER_APP_DATA_DIR
+
+// Symbols normally provided by main/Smart_Embed.c and read by http_server_app
+float g_distance = 0.0f;
+bool g_distance_valid = false;
+volatile uint32_t g_distance_seq = 0;
+volatile int g_led_status = 0;
+
+// Deterministic "target walking back and forth" between 5 cm and 200 cm
+static float fake_distance(uint32_t n)
+{
+    return 102.5f + 97.5f * sinf((float)n * 0.05f);
+}
+
+// In-memory SD card: sensor.csv lives on tmpfs and goes through log_store like
+// sdcard_save_sensor_data(), so handlers read committed rows plus the RAM tail
+static bool fake_sd_append(float distance, long long timestamp)
+{
+    char row[40];
+    int n = snprintf(row, sizeof(row), "%.2f,%lld\n", distance, timestamp);
+    return log_store_append(LOG_STORE_SENSOR, row, n) == ESP_OK &&
+           log_store_commit(LOG_STORE_SENSOR, false) != ESP_FAIL;
+}
+
+static bool fake_sd_prefill(int rows)
+{
+    if (mkdir(BENCH_DATA_DIR, 0755) != 0 && errno != EEXIST) {
+        ESP_LOGE(TAG, "Cannot create %s", BENCH_DATA_DIR);
+        return false;
+    }
+    FILE *f = fopen(BENCH_DATA_DIR "/sensor.csv", "w");
+    if (!f) return false;
+    long long timestamp = 0;
+    for (int i = 0; i < rows; i++) {
+        timestamp += CONFIG_HTTP_BENCH_SAMPLE_PERIOD_MS;
+        fprintf(f, "%.2f,%lld\n", fake_distance(i), timestamp);
+    }
+    fclose(f);
+    return true;
+}
+
+// Stands in for sensor_task + sdcard_task so handlers see a live sample stream
+// and the history file keeps growing while the load generator runs.
+static void fake_sensor_task(void *pvParameters)
+{
+    uint32_t n = CONFIG_HTTP_BENCH_HISTORY_ROWS;
+    uint32_t seq = 0;
+    while (1) {
+        int64_t t_trigger_us = esp_timer_get_time();
+        float distance = fake_distance(n++);
+        sample_trace_begin(++seq, t_trigger_us);
+        g_distance = distance;
+        g_distance_valid = true;
+        g_distance_seq = seq;
+        sample_trace_mark(seq, SAMPLE_STAGE_SNAPSHOT);
+        sample_ring_item_t item = { .seq = seq, .t_us = t_trigger_us, .distance = distance, .valid = true };
+        sample_stats_add(&item);
+        distance_hist_add(&item);
+        bool alert = approach_tracker_update(&item);
+        g_led_status = occupancy_update(&item) || alert;
+        if (fake_sd_append(distance, t_trigger_us / 1000)) {
+            sample_trace_mark(seq, SAMPLE_STAGE_SD_STAGED);
+        }
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_HTTP_BENCH_SAMPLE_PERIOD_MS));
+    }
+}
+
+void app_main(void)
+{
+    if (!fake_sd_prefill(CONFIG_HTTP_BENCH_HISTORY_ROWS)) {
+        ESP_LOGE(TAG, "Failed to prepare fake SD data in %s", BENCH_DATA_DIR);
+        return;
+    }
+
+    ESP_ERROR_CHECK(log_store_init(BENCH_DATA_DIR));
+    ESP_ERROR_CHECK(sample_stats_init());
+    ESP_ERROR_CHECK(distance_hist_init());
+    xTaskCreate(fake_sensor_task, "sensor_task", 4096, NULL, 3, NULL);
+
+    start_webserver();
+    printf("http_bench: listening on port %d, %d history rows in %s\n",
+           CONFIG_HTTP_SERVER_APP_PORT, CONFIG_HTTP_BENCH_HISTORY_ROWS, BENCH_DATA_DIR);
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(10000));
+    }
+}
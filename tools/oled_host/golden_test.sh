@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+# SPDX-FileCopyrightText: 2025
+# SPDX-License-Identifier: CC0-1.0
+#
+# Pixel-diff test of the OLED screens: builds the host renderer (linux target), renders every
+# scene and compares it with golden/<scene>.pbm. Exit code 0 = identical, 1 = a scene differs
+# or is missing, anything else = build/run failure.
+#
+#   ./golden_test.sh            # build, then compare
+#   ./golden_test.sh --update   # build, then overwrite golden/ (layout change on purpose)
+set -euo pipefail
+
+cd "$(dirname "$0")"
+
+if ! grep -qs '^CONFIG_IDF_TARGET="linux"' sdkconfig; then
+    idf.py --preview set-target linux >/dev/null
+fi
+idf.py build >/dev/null
+
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+if [ "${1:-}" = "--update" ]; then
+    OLED_HOST_OUT=golden ./build/oled_host.elf
+    exit 0
+fi
+
+OLED_HOST_OUT="$out" OLED_HOST_GOLDEN=golden ./build/oled_host.elf
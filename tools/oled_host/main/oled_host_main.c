@@ -0,0 +1,231 @@
+/*
+ * SPDX-FileCopyrightText: 2025
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "oled_driver.h"
+#include "oled_panel_host.h"
+#include "display_ui.h"
+#if CONFIG_OLED_DRIVER_BENCHMARK
+#include "oled_bench.h"
+#endif
+
+static const char *TAG = "oled_host";
+
+// One screen of display_task: samples fed to the trend graph, then the current reading
+typedef struct {
+    const char *name;
+    int samples;            // Samples pushed into the sparkline
+    int gap_every;          // Every n-th sample is out of range (0 = none)
+    bool reading;           // false: title and separator only, as right after boot
+    float distance;         // Reading shown under the graph
+    bool valid;
+    float stats_mean;       // 1 h statistics in the status line (0 = none)
+    float stats_p95;
+} scene_t;
+
+static const scene_t s_scenes[] = {
+    { "boot",         0,   0,  false, 0.0f,   false, 0.0f,   0.0f },
+    { "distance",     64,  0,  true,  123.4f, true,  0.0f,   0.0f },
+    { "out_of_range", 64,  16, true,  0.0f,   false, 0.0f,   0.0f },
+    { "trend_full",   300, 37, true,  387.5f, true,  0.0f,   0.0f },
+    { "near",         128, 0,  true,  2.1f,   true,  0.0f,   0.0f },
+    { "stats",        128, 0,  true,  123.4f, true,  107.6f, 189.5f },
+};
+
+// Triangle wave between 20 and 195 cm: exact in float, so images do not depend on libm
+static float fake_distance(int n)
+{
+    int t = n % 100;
+    return 20.0f + 3.5f * (float)(t < 50 ? t : 100 - t);
+}
+
+// Draw one scene from a blank screen and wait until the panel has it
+static void render_scene(oled_driver_t *oled, const scene_t *scene)
+{
+    display_ui_t ui;
+    display_ui_init(&ui);
+    display_ui_set_stats(&ui, scene->stats_mean, scene->stats_p95, scene->stats_mean > 0.0f);
+
+    oled_flush_wait(oled, 1000);
+    oled_begin_frame(oled);
+    display_ui_draw_static(oled, &ui);
+    for (int n = 0; n < scene->samples; n++) {
+        bool valid = !(scene->gap_every && n % scene->gap_every == scene->gap_every - 1);
+        display_ui_push_sample(oled, &ui, fake_distance(n), valid);
+    }
+    if (scene->reading) {
+        display_ui_show(oled, &ui, scene->distance, scene->valid);
+    }
+    oled_end_frame(oled);
+    oled_flush_wait(oled, 1000);
+}
+
+// Render every scene to out_dir; with a golden dir, count scenes whose pixels differ
+static int run_scenes(oled_driver_t *oled, const char *out_dir, const char *golden_dir)
+{
+    char path[256];
+    int failures = 0;
+    const oled_panel_t *panel = oled_get_panel(oled);
+
+    for (size_t i = 0; i < sizeof(s_scenes) / sizeof(s_scenes[0]); i++) {
+        const scene_t *scene = &s_scenes[i];
+        render_scene(oled, scene);
+
+        snprintf(path, sizeof(path), "%s/%s.pbm", out_dir, scene->name);
+        if (oled_panel_host_write_pbm(panel, path) != ESP_OK) {
+            failures++;
+            continue;
+        }
+        if (!golden_dir) {
+            printf("%-14s %s\n", scene->name, path);
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "%s/%s.pbm", golden_dir, scene->name);
+        uint32_t diff = 0;
+        esp_err_t err = oled_panel_host_diff_pbm(panel, path, &diff);
+        if (err == ESP_OK && diff == 0) {
+            printf("%-14s ok\n", scene->name);
+        } else if (err == ESP_OK) {
+            printf("%-14s FAIL: %" PRIu32 " pixels differ (see %s/%s.pbm)\n", scene->name, diff, out_dir,
+                   scene->name);
+            failures++;
+        } else {
+            printf("%-14s FAIL: %s (%s)\n", scene->name, path, esp_err_to_name(err));
+            failures++;
+        }
+    }
+    return failures;
+}
+
+typedef void (*frame_fn_t)(oled_driver_t *oled, display_ui_t *ui, int n);
+
+// Steady state: one new sample scrolls in and the reading changes
+static void frame_sample(oled_driver_t *oled, display_ui_t *ui, int n)
+{
+    display_ui_push_sample(oled, ui, fake_distance(n), true);
+    display_ui_show(oled, ui, fake_distance(n), true);
+}
+
+// Text only: alternate two readings so the numeric label redraws every frame
+static void frame_text(oled_driver_t *oled, display_ui_t *ui, int n)
+{
+    oled_display_text(oled, (n & 1) ? "Distance: 123.4 cm" : "Distance: 56.7 cm", 64, 40,
+                      OLED_FONT_SMALL, OLED_ALIGN_CENTER);
+    oled_display_text(oled, "42", 64, 10, OLED_FONT_LARGE, OLED_ALIGN_CENTER);
+}
+
+// Fills: lower half cleared and a bar redrawn
+static void frame_fill(oled_driver_t *oled, display_ui_t *ui, int n)
+{
+    oled_clear_region(oled, 0, 32, 128, 32);
+    oled_draw_rectangle(oled, 4, 58, 8 + n % 112, 6, 1, 1);
+}
+
+// Lines: axis-aligned frame plus two diagonals
+static void frame_line(oled_driver_t *oled, display_ui_t *ui, int n)
+{
+    oled_draw_rectangle(oled, 0, 0, 128, 64, 0, 1);
+    oled_draw_line(oled, 0, 0, 127, n % 64, 1);
+    oled_draw_line(oled, 127, 0, 0, 63 - n % 64, 1);
+}
+
+// Whole screen from scratch, as after boot
+static void frame_full(oled_driver_t *oled, display_ui_t *ui, int n)
+{
+    display_ui_init(ui);
+    display_ui_draw_static(oled, ui);
+    display_ui_show(oled, ui, fake_distance(n), true);
+}
+
+static const struct {
+    const char *name;
+    frame_fn_t fn;
+    bool flush;             // Include commit + transfer to the panel
+} s_bench[] = {
+    { "text",               frame_text,   false },
+    { "fill",               frame_fill,   false },
+    { "line",               frame_line,   false },
+    { "sample frame",       frame_sample, false },
+    { "full redraw",        frame_full,   false },
+    { "sample frame+flush", frame_sample, true },
+    { "full redraw+flush",  frame_full,   true },
+};
+
+static void run_bench(oled_driver_t *oled, int frames)
+{
+    static display_ui_t ui;
+    for (size_t i = 0; i < sizeof(s_bench) / sizeof(s_bench[0]); i++) {
+        display_ui_init(&ui);
+        oled_begin_frame(oled);
+        display_ui_draw_static(oled, &ui);
+        oled_end_frame(oled);
+        oled_flush_wait(oled, 1000);
+
+        if (!s_bench[i].flush) {
+            // Outer frame: the per-frame end is a no-op, only drawing and dirty tracking are timed
+            oled_begin_frame(oled);
+        }
+        int64_t start = esp_timer_get_time();
+        for (int n = 0; n < frames; n++) {
+            oled_begin_frame(oled);
+            s_bench[i].fn(oled, &ui, n);
+            oled_end_frame(oled);
+            if (s_bench[i].flush) {
+                oled_flush_wait(oled, 1000);
+            }
+        }
+        int64_t elapsed = esp_timer_get_time() - start;
+        if (!s_bench[i].flush) {
+            oled_end_frame(oled);
+            oled_flush_wait(oled, 1000);
+        }
+        printf("%-20s %8.2f us/frame\n", s_bench[i].name, (double)elapsed / frames);
+    }
+}
+
+void app_main(void)
+{
+    const char *out_dir = getenv("OLED_HOST_OUT");
+    const char *golden_dir = getenv("OLED_HOST_GOLDEN");
+    if (!out_dir) {
+        out_dir = CONFIG_OLED_HOST_OUT_DIR;
+    }
+    if (mkdir(out_dir, 0755) != 0 && errno != EEXIST) {
+        ESP_LOGE(TAG, "Cannot create %s", out_dir);
+        exit(2);
+    }
+
+    oled_config_t config = {
+        .width = 128,
+        .height = 64,
+    };
+    oled_driver_t *oled = NULL;
+    ESP_ERROR_CHECK(oled_init(&config, &oled));
+
+    int failures = run_scenes(oled, out_dir, golden_dir);
+
+#if CONFIG_OLED_DRIVER_BENCHMARK
+    oled_bench_run(oled);
+#endif
+    if (CONFIG_OLED_HOST_BENCH_FRAMES > 0) {
+        run_bench(oled, CONFIG_OLED_HOST_BENCH_FRAMES);
+    }
+
+    oled_deinit(oled);
+    if (golden_dir) {
+        printf("oled_host: %d scene(s) differ from %s\n", failures, golden_dir);
+    }
+    exit(failures ? 1 : 0);
+}
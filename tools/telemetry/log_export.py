@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2025
+# SPDX-License-Identifier: CC0-1.0
+"""Download the SD card logs of one or more devices through GET /export.
+
+    python3 log_export.py 192.168.1.100                    # into ./export/192.168.1.100/
+    python3 log_export.py dev1.local dev2.local -j 8 -o /data/fleet
+    python3 log_export.py 192.168.1.100 --file events.csv
+
+Each log file is served in fixed-size segments (CONFIG_LOG_STORE_SEGMENT_KB).
+Segments are fetched in parallel (across devices too) into <out>/<host>/<file>.d/
+and joined into <out>/<host>/<file> once all of them are complete.
+
+Every request carries Range and If-Range with the ETag of the copy on disk, so:
+- an interrupted segment continues where it stopped (206),
+- a complete segment costs one empty 416 reply,
+- a segment that changed (the growing last one, another card) is sent whole (200).
+Run it again to pick up what was added since.
+"""
+
+import argparse
+import http.client
+import json
+import os
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+
+
+class Device:
+    def __init__(self, spec, timeout):
+        host, _, port = spec.partition(":")
+        self.host = host
+        self.port = int(port) if port else 80
+        self.timeout = timeout
+
+    def request(self, path, headers=None):
+        conn = http.client.HTTPConnection(self.host, self.port, timeout=self.timeout)
+        conn.request("GET", path, headers=headers or {})
+        return conn, conn.getresponse()
+
+    def index(self):
+        conn, resp = self.request("/export")
+        try:
+            if resp.status != 200:
+                raise RuntimeError("GET /export: HTTP %d" % resp.status)
+            return json.loads(resp.read())
+        finally:
+            conn.close()
+
+
+def fetch_segment(dev, name, seg, out_dir):
+    """Bring <out_dir>/<seg>.seg up to date; return the bytes transferred."""
+    final = os.path.join(out_dir, "%05d.seg" % seg)
+    part = final + ".part"
+    tag_file = final + ".etag"
+    etag = None
+    if os.path.exists(tag_file):
+        with open(tag_file) as f:
+            etag = f.read().strip() or None
+    if os.path.exists(final) and not os.path.exists(part):
+        os.replace(final, part)
+    have = os.path.getsize(part) if os.path.exists(part) else 0
+
+    headers = {}
+    if etag:
+        headers = {"Range": "bytes=%d-" % have, "If-Range": etag}
+    conn, resp = dev.request("/export?file=%s&seg=%d" % (name, seg), headers)
+    try:
+        new_tag = resp.getheader("ETag")
+        if resp.status == 416 and etag and new_tag == etag:
+            resp.read()
+            os.replace(part, final)
+            return 0
+        if resp.status == 206:
+            start = int(resp.getheader("Content-Range").split()[1].split("-")[0])
+            if start != have:
+                raise RuntimeError("resumed at %d, asked for %d" % (start, have))
+            mode = "ab"
+        elif resp.status == 200:
+            mode = "wb"
+        else:
+            # 416 for a copy that is no longer valid: start over next attempt
+            resp.read()
+            for path in (part, tag_file):
+                if os.path.exists(path):
+                    os.remove(path)
+            raise RuntimeError("HTTP %d" % resp.status)
+
+        # Tag first: if the transfer breaks, the next attempt resumes against it
+        with open(tag_file, "w") as f:
+            f.write(new_tag or "")
+        length = int(resp.getheader("Content-Length"))
+        got = 0
+        with open(part, mode) as f:
+            while True:
+                block = resp.read(16384)
+                if not block:
+                    break
+                f.write(block)
+                got += len(block)
+        if got != length:
+            raise RuntimeError("short body: %d of %d bytes" % (got, length))
+        os.replace(part, final)
+        return got
+    finally:
+        conn.close()
+
+
+def fetch_with_retries(dev, name, seg, out_dir, retries):
+    delay = 1.0
+    for attempt in range(retries + 1):
+        try:
+            return fetch_segment(dev, name, seg, out_dir)
+        except (OSError, http.client.HTTPException, RuntimeError, ValueError) as e:
+            if attempt == retries:
+                raise
+            print("%s %s seg %d: %s, retrying in %.0f s" % (dev.host, name, seg, e, delay), file=sys.stderr)
+            time.sleep(delay)
+            delay = min(delay * 2, 30.0)
+
+
+def join(out_dir, target, segments):
+    with open(target + ".tmp", "wb") as out:
+        for seg in range(segments):
+            with open(os.path.join(out_dir, "%05d.seg" % seg), "rb") as f:
+                out.write(f.read())
+    os.replace(target + ".tmp", target)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("devices", nargs="+", help="host or host:port")
+    parser.add_argument("-o", "--out", default="export", help="output directory")
+    parser.add_argument("-j", "--jobs", type=int, default=4, help="parallel segment downloads")
+    parser.add_argument("--file", action="append", help="only this log file (repeatable)")
+    parser.add_argument("--retries", type=int, default=5)
+    parser.add_argument("--timeout", type=float, default=10.0, help="socket timeout (s)")
+    args = parser.parse_args()
+
+    jobs = []   # (device, file name, segments, directory)
+    failed = 0
+    for spec in args.devices:
+        dev = Device(spec, args.timeout)
+        try:
+            index = dev.index()
+        except (OSError, http.client.HTTPException, RuntimeError, ValueError) as e:
+            print("%s: %s" % (spec, e), file=sys.stderr)
+            failed += 1
+            continue
+        for entry in index["files"]:
+            if args.file and entry["name"] not in args.file:
+                continue
+            out_dir = os.path.join(args.out, dev.host, entry["name"] + ".d")
+            os.makedirs(out_dir, exist_ok=True)
+            jobs.append((dev, entry["name"], entry["segments"], out_dir))
+
+    started = time.monotonic()
+    total = 0
+    errors = {}
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = {}
+        for dev, name, segments, out_dir in jobs:
+            for seg in range(segments):
+                f = pool.submit(fetch_with_retries, dev, name, seg, out_dir, args.retries)
+                futures[f] = (dev, name)
+        for f in as_completed(futures):
+            key = futures[f]
+            try:
+                total += f.result()
+            except Exception as e:  # noqa: BLE001 - reported per file below
+                errors.setdefault(key, str(e))
+
+    for dev, name, segments, out_dir in jobs:
+        target = os.path.join(args.out, dev.host, name)
+        if (dev, name) in errors:
+            print("%s %s: incomplete (%s); run again to resume" % (dev.host, name, errors[(dev, name)]),
+                  file=sys.stderr)
+            failed += 1
+        elif segments:
+            join(out_dir, target, segments)
+            print("%s %s: %d segments -> %s" % (dev.host, name, segments, target))
+    elapsed = time.monotonic() - started
+    print("%d bytes transferred in %.1f s (%.0f KB/s)" %
+          (total, elapsed, total / 1024.0 / elapsed if elapsed else 0.0), file=sys.stderr)
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
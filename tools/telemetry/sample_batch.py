@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2025
+# SPDX-License-Identifier: CC0-1.0
+"""Decode smart_embed.Batch messages (components/sample_batch/proto/smart_embed.proto).
+
+Reads one payload per line as hex, optionally prefixed by the topic, which is what
+mosquitto_sub prints with -F '%t %x':
+
+    mosquitto_sub -h <broker> -q 1 -t 'smart_embed/+/samples' -F '%t %x' | python3 sample_batch.py
+
+With --stream, reads length-delimited Batch messages from stdin instead, as
+served by GET /sensor/history?format=pb:
+
+    curl -s 'http://<device>/sensor/history?limit=1000&format=pb' | python3 sample_batch.py --stream
+
+Prints one line per sample and warns about missing or repeated batches.
+"""
+
+import sys
+
+SCHEMA_VERSION = 1
+
+
+class Batch:
+    def __init__(self, boot_id, batch_seq, first_seq, t0_ms, samples):
+        self.boot_id = boot_id
+        self.batch_seq = batch_seq
+        self.first_seq = first_seq
+        self.t0_ms = t0_ms
+        self.samples = samples  # [(seq, t_ms, distance_cm or None)]
+
+
+def _varint(data, pos):
+    value = shift = 0
+    while True:
+        if pos >= len(data):
+            raise ValueError("truncated varint")
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return value, pos
+        shift += 7
+
+
+def parse_fields(data):
+    """Minimal protobuf reader: {field number: [values]}; LEN fields stay bytes."""
+    fields = {}
+    pos = 0
+    while pos < len(data):
+        key, pos = _varint(data, pos)
+        field, wire = key >> 3, key & 7
+        if wire == 0:
+            value, pos = _varint(data, pos)
+        elif wire == 1:
+            value, pos = data[pos:pos + 8], pos + 8
+        elif wire == 2:
+            n, pos = _varint(data, pos)
+            value, pos = data[pos:pos + n], pos + n
+        elif wire == 5:
+            value, pos = data[pos:pos + 4], pos + 4
+        else:
+            raise ValueError("unsupported wire type %d" % wire)
+        if pos > len(data):
+            raise ValueError("truncated field %d" % field)
+        fields.setdefault(field, []).append(value)
+    return fields
+
+
+def _packed(fields, number):
+    values = []
+    for chunk in fields.get(number, []):
+        if isinstance(chunk, int):      # Unpacked encoding is valid too
+            values.append(chunk)
+            continue
+        pos = 0
+        while pos < len(chunk):
+            v, pos = _varint(chunk, pos)
+            values.append(v)
+    return values
+
+
+def decode(payload):
+    """Decode one Batch message; raises ValueError on malformed input."""
+    fields = parse_fields(payload)
+
+    def one(number):
+        # proto3: a missing scalar is 0, the last occurrence wins
+        return fields.get(number, [0])[-1]
+
+    version = one(1)
+    if version != SCHEMA_VERSION:
+        raise ValueError("unknown schema version %d" % version)
+    dt = _packed(fields, 6)
+    mm = _packed(fields, 7)
+    if len(dt) != len(mm):
+        raise ValueError("column lengths differ (%d, %d)" % (len(dt), len(mm)))
+
+    first_seq, t_ms = one(4), one(5)
+    samples = []
+    for i, (dt_ms, d) in enumerate(zip(dt, mm)):
+        t_ms += dt_ms
+        samples.append((first_seq + i, t_ms, d / 10.0 if d else None))
+    return Batch(one(2), one(3), first_seq, one(5), samples)
+
+
+class Tracker:
+    """Detects gaps and duplicates per device and boot (delivery is at-least-once)."""
+
+    def __init__(self):
+        self.next_seq = {}
+
+    def check(self, device, batch):
+        key = (device, batch.boot_id)
+        expected = self.next_seq.get(key)
+        if expected is not None and batch.batch_seq < expected:
+            return "duplicate"
+        self.next_seq[key] = batch.batch_seq + 1
+        if expected is not None and batch.batch_seq > expected:
+            return "gap of %d batches" % (batch.batch_seq - expected)
+        return None
+
+
+def read_delimited(data):
+    """Split a stream of varint-length-prefixed messages."""
+    pos = 0
+    while pos < len(data):
+        n, pos = _varint(data, pos)
+        if pos + n > len(data):
+            raise ValueError("truncated message")
+        yield data[pos:pos + n]
+        pos += n
+
+
+def print_samples(device, batch):
+    for seq, t_ms, cm in batch.samples:
+        print("%s %04x %d %d %s" % (device, batch.boot_id, seq, t_ms, "-" if cm is None else "%.1f" % cm))
+
+
+def main():
+    if "--stream" in sys.argv[1:]:
+        for message in read_delimited(sys.stdin.buffer.read()):
+            print_samples("-", decode(message))
+        return
+
+    tracker = Tracker()
+    for line in sys.stdin:
+        parts = line.split()
+        if not parts:
+            continue
+        device = parts[0] if len(parts) > 1 else "-"
+        try:
+            batch = decode(bytes.fromhex(parts[-1]))
+        except ValueError as e:
+            print("%s: %s" % (device, e), file=sys.stderr)
+            continue
+        note = tracker.check(device, batch)
+        if note:
+            print("%s: boot %04x batch %d: %s" % (device, batch.boot_id, batch.batch_seq, note),
+                  file=sys.stderr)
+            if note == "duplicate":
+                continue
+        print_samples(device, batch)
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2025
+# SPDX-License-Identifier: CC0-1.0
+"""Reference receiver for the UDP telemetry stream (components/udp_telemetry).
+
+    python3 udp_receiver.py                     # unicast, port 5005
+    python3 udp_receiver.py --group 239.1.2.3   # join the firmware's default multicast group
+    python3 udp_receiver.py --quiet             # loss statistics only
+
+Samples go to stdout as "device boot seq t_ms distance_cm"; per-stream loss
+statistics go to stderr every --stats seconds and on Ctrl+C.
+"""
+
+import argparse
+import signal
+import socket
+import struct
+import sys
+import time
+
+import sample_batch
+
+PREFIX = struct.Struct("<ccBB4s")
+VERSION = 2
+
+
+class Stream:
+    """Loss accounting for one (device, boot) stream from batch_seq."""
+
+    MAX_MISSING = 4096
+
+    def __init__(self, first_seq):
+        self.next_seq = first_seq
+        self.missing = set()
+        self.received = 0
+        self.late = 0
+        self.duplicates = 0
+
+    @property
+    def lost(self):
+        return len(self.missing)
+
+    def update(self, seq):
+        """Return False for a duplicate batch, which must not be used again."""
+        if seq >= self.next_seq:
+            self.missing.update(range(self.next_seq, seq))
+            self.next_seq = seq + 1
+            if len(self.missing) > self.MAX_MISSING:
+                self.missing = {m for m in self.missing if m >= self.next_seq - self.MAX_MISSING}
+        elif seq in self.missing:
+            # Reordered in the network: counted as lost until now
+            self.missing.discard(seq)
+            self.late += 1
+        else:
+            self.duplicates += 1
+            return False
+        self.received += 1
+        return True
+
+
+def report(streams):
+    for (device, boot), s in sorted(streams.items()):
+        total = s.received + s.lost
+        print("%s boot %04x: %d batches, %d lost (%.2f%%), %d late, %d duplicate" %
+              (device, boot, s.received, s.lost, 100.0 * s.lost / total if total else 0.0, s.late,
+               s.duplicates), file=sys.stderr)
+
+
+def on_sigterm(signum, frame):
+    # Print the final statistics when stopped by a supervisor, as on Ctrl+C
+    raise KeyboardInterrupt
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=5005)
+    parser.add_argument("--bind", default="0.0.0.0", help="local address to listen on")
+    parser.add_argument("--group", help="multicast group to join")
+    parser.add_argument("--stats", type=float, default=10.0, help="statistics period (s, 0 = off)")
+    parser.add_argument("--quiet", action="store_true", help="do not print samples")
+    args = parser.parse_args()
+    signal.signal(signal.SIGTERM, on_sigterm)
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    # Bound to the group address, the socket only gets datagrams sent to that group
+    sock.bind((args.group or args.bind, args.port))
+    if args.group:
+        mreq = socket.inet_aton(args.group) + socket.inet_aton(args.bind)
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+    sock.settimeout(1.0)
+
+    streams = {}
+    next_stats = time.monotonic() + args.stats
+    try:
+        while True:
+            try:
+                data, addr = sock.recvfrom(2048)
+            except socket.timeout:
+                data = None
+            if data:
+                handle(data, addr, streams, args.quiet)
+            if args.stats and time.monotonic() >= next_stats:
+                next_stats += args.stats
+                report(streams)
+    except KeyboardInterrupt:
+        pass
+    report(streams)
+
+
+def handle(data, addr, streams, quiet):
+    if len(data) < PREFIX.size:
+        return
+    m0, m1, version, _, device_id = PREFIX.unpack_from(data)
+    if m0 != b"S" or m1 != b"E" or version != VERSION:
+        print("%s: not a telemetry datagram" % addr[0], file=sys.stderr)
+        return
+    try:
+        batch = sample_batch.decode(data[PREFIX.size:])
+    except ValueError as e:
+        print("%s: %s" % (addr[0], e), file=sys.stderr)
+        return
+
+    device = device_id.hex()
+    key = (device, batch.boot_id)
+    stream = streams.get(key)
+    if stream is None:
+        stream = streams[key] = Stream(batch.batch_seq)
+    if not stream.update(batch.batch_seq) or quiet:
+        return
+    sample_batch.print_samples(device, batch)
+    sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()